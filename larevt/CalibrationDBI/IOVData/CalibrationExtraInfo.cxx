@@ -51,6 +51,17 @@ namespace lariov {
     fStringData.clear();
   }
 
+  bool CalibrationExtraInfo::IsEmpty() const {
+    return fBoolData.empty() && fIntData.empty() && fVecIntData.empty() &&
+           fFloatData.empty() && fVecFloatData.empty() && fStringData.empty();
+  }
+
+  std::shared_ptr<const CalibrationExtraInfo> CalibrationExtraInfo::Share(CalibrationExtraInfo const& info,
+                                                                          CalibrationExtraInfo const& empty) {
+    if (info.IsEmpty() && info.GetName() == empty.GetName()) return nullptr;
+    return std::make_shared<const CalibrationExtraInfo>(info);
+  }
+
   bool CalibrationExtraInfo::GetBoolData(std::string const& label) const {
     if (fBoolData.find(label) != fBoolData.end()) {
       return fBoolData.at(label);
@@ -1,6 +1,7 @@
 #ifndef CALIBRATIONEXTRAINFO_H
 #define CALIBRATIONEXTRAINFO_H
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <map>
@@ -37,6 +38,17 @@ namespace lariov {
       void ClearDataByLabel(std::string const& label);
       void ClearAllData();
 
+      /// True if no data of any kind is held
+      bool IsEmpty() const;
+
+      /**
+         Out-of-line copy of info for a calibration row to hold, or null if info
+         holds no data and has the name of empty, the info without data that
+         the row returns when it holds null.  Nearly all rows hold null.
+      */
+      static std::shared_ptr<const CalibrationExtraInfo> Share(CalibrationExtraInfo const& info,
+                                                               CalibrationExtraInfo const& empty);
+
 
 
     private:
@@ -15,6 +15,7 @@
 #define IOVDATA_DETPEDESTAL_H 1
 
 #include "ChData.h"
+#include "SnapshotFields.h"
 
 namespace lariov {
   /**
@@ -48,6 +49,18 @@ namespace lariov {
       float fPedRmsErr;
 
   }; // end class
+
+  /// Fields of a pedestal row kept as columns by Snapshot
+  template <>
+  struct SnapshotFields<DetPedestal> {
+    enum Field_t { kPedMean, kPedRms, kPedMeanErr, kPedRmsErr, kNFields };
+    static constexpr float (DetPedestal::*Getters[kNFields])() const = {
+      &DetPedestal::PedMean,
+      &DetPedestal::PedRms,
+      &DetPedestal::PedMeanErr,
+      &DetPedestal::PedRmsErr
+    };
+  };
 } // end namespace lariov
 
 #endif
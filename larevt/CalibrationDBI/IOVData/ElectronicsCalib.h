@@ -15,6 +15,7 @@
 #define IOVDATA_ELECTRONICSCALIB_H
 
 #include "ChData.h"
+#include "SnapshotFields.h"
 #include "CalibrationExtraInfo.h"
 
 namespace lariov {
@@ -27,8 +28,7 @@ namespace lariov {
 
       /// Constructor
       ElectronicsCalib(unsigned int ch) :
-        ChData(ch),
-	fExtraInfo("ElectronicsCalib") {}
+        ChData(ch) {}
 
       /// Default destructor
       ~ElectronicsCalib() {}
@@ -37,14 +37,20 @@ namespace lariov {
       float GainErr() const { return fGainErr; }
       float ShapingTime()    const { return fShapingTime; }
       float ShapingTimeErr() const { return fShapingTimeErr; }
-      CalibrationExtraInfo const& ExtraInfo() const { return fExtraInfo; }
+      CalibrationExtraInfo const& ExtraInfo() const { return fExtraInfo ? *fExtraInfo : NoExtraInfo(); }
 
       void SetGain(float v)    { fGain    = v; }
       void SetGainErr(float v) { fGainErr = v; }
       void SetShapingTime(float v)    { fShapingTime    = v; }
       void SetShapingTimeErr(float v) { fShapingTimeErr = v; }
       void SetExtraInfo(CalibrationExtraInfo const& info)
-      { fExtraInfo = info; }
+      { fExtraInfo = CalibrationExtraInfo::Share(info, NoExtraInfo()); }
+
+      /// The extra info of rows without extra data, shared by all of them
+      static CalibrationExtraInfo const& NoExtraInfo() {
+        static const CalibrationExtraInfo info("ElectronicsCalib");
+        return info;
+      }
 
     private:
 
@@ -52,9 +58,21 @@ namespace lariov {
       float fGainErr;
       float fShapingTime;
       float fShapingTimeErr;
-      CalibrationExtraInfo fExtraInfo;
+      std::shared_ptr<const CalibrationExtraInfo> fExtraInfo;  //Null for the usual rows without extra data
 
   }; // end class
+
+  /// Fields of a electronics calibration row kept as columns by Snapshot
+  template <>
+  struct SnapshotFields<ElectronicsCalib> {
+    enum Field_t { kGain, kGainErr, kShapingTime, kShapingTimeErr, kNFields };
+    static constexpr float (ElectronicsCalib::*Getters[kNFields])() const = {
+      &ElectronicsCalib::Gain,
+      &ElectronicsCalib::GainErr,
+      &ElectronicsCalib::ShapingTime,
+      &ElectronicsCalib::ShapingTimeErr
+    };
+  };
 } // end namespace lariov
 
 #endif
@@ -14,93 +14,64 @@
 #include "IOVTimeStamp.h"
 #include "IOVDataError.h"
 #include "IOVDataConstants.h"
-#include <sstream>
-#include <limits>
-#include <iomanip>
+#include <cctype>
+#include <charconv>
 
 namespace lariov {
 
+  void IOVTimeStamp::ThrowBadSubStamp() {
+    throw IOVDataError("SubStamp of an IOVTimeStamp cannot have more than six digits!");
+  }
 
   /**Create unique database timestamp of the form <fStamp>.<fSubStamp>,
      where fSubStamp is prepended with zeroes to ensure six digits
   */
-  void IOVTimeStamp::CalcDBStamp() {
-    if (fSubStamp > kMAX_SUBSTAMP_VALUE) {
-      throw IOVDataError("SubStamp of an IOVTimeStamp cannot have more than six digits!");
+  std::string IOVTimeStamp::DBStamp() const {
+    char buf[std::numeric_limits<unsigned long>::digits10 + 2 + kMAX_SUBSTAMP_LENGTH + 1];
+    char* p = std::to_chars(buf, buf + sizeof(buf), fStamp).ptr;
+    *p++ = '.';
+    unsigned int substamp = fSubStamp;
+    for (int i = kMAX_SUBSTAMP_LENGTH-1; i >= 0; --i) {
+      p[i] = '0' + substamp%10;
+      substamp /= 10;
     }
-    std::stringstream stream;
-    stream << fStamp <<"."<<std::setfill('0')<<std::setw(kMAX_SUBSTAMP_LENGTH)<< fSubStamp;
-    fDBStamp = stream.str();
+    return std::string(buf, p + kMAX_SUBSTAMP_LENGTH);
   }
 
+  /**Parse <stamp>[.<substamp>]; the fractional part has at most six digits
+     and is right-padded with zeroes, so "12.5" is stamp 12, substamp 500000
+  */
   IOVTimeStamp IOVTimeStamp::GetFromString(const std::string& ts) {
-    unsigned long stamp;
-    std::string substamp_str;
-    if (ts.find_first_of(".") == std::string::npos) {
-      stamp = std::stoul(ts);
-      substamp_str = "0";
-    }
-    else {
-      stamp = std::stoul(ts.substr(0, ts.find_first_of(".")));
-      substamp_str = ts.substr(ts.find_first_of(".")+1);
+
+    const char* begin = ts.data();
+    const char* end = begin + ts.size();
+    while (begin != end && std::isspace((unsigned char)*begin)) ++begin;
+    while (end != begin && std::isspace((unsigned char)end[-1])) --end;
+
+    unsigned long stamp = 0;
+    auto res = std::from_chars(begin, end, stamp);
+    if (res.ec != std::errc() || (res.ptr != end && *res.ptr != '.')) {
+      throw IOVDataError("Cannot read an IOVTimeStamp from \"" + ts + "\"");
     }
 
-    if (substamp_str.length() > kMAX_SUBSTAMP_LENGTH) {
-      throw IOVDataError("SubStamp of an IOVTimeStamp cannot have more than six digits!");
+    unsigned int substamp = 0;
+    if (res.ptr != end) {
+      const char* digit = res.ptr + 1;
+      if (end - digit > kMAX_SUBSTAMP_LENGTH) {
+        throw IOVDataError("SubStamp of an IOVTimeStamp cannot have more than six digits!");
+      }
+      for (int i = 0; i != kMAX_SUBSTAMP_LENGTH; ++i) {
+        unsigned int d = 0;
+        if (digit != end) {
+          if (!std::isdigit((unsigned char)*digit)) {
+            throw IOVDataError("Cannot read an IOVTimeStamp from \"" + ts + "\"");
+          }
+          d = *digit++ - '0';
+        }
+        substamp = 10*substamp + d;
+      }
     }
-    while (substamp_str.length() < kMAX_SUBSTAMP_LENGTH) substamp_str += "0";
-    unsigned int substamp = std::stoi(substamp_str);
 
     return IOVTimeStamp(stamp,substamp);
   }
-
-  IOVTimeStamp IOVTimeStamp::MinTimeStamp() {
-    return IOVTimeStamp(0,0);
-  }
-
-  IOVTimeStamp IOVTimeStamp::MaxTimeStamp() {
-    return IOVTimeStamp(std::numeric_limits<unsigned long>::max(), kMAX_SUBSTAMP_VALUE);
-  }
-
-  ///implementation of assignment operator
-  IOVTimeStamp& IOVTimeStamp::operator=( const IOVTimeStamp& ts ) {
-    if (this == &ts) return *this;
-    fStamp = ts.Stamp();
-    fSubStamp = ts.SubStamp();
-    fDBStamp = ts.DBStamp();
-    return *this;
-  }
-
-  ///implementation of operator<
-  bool IOVTimeStamp::operator<(const IOVTimeStamp& ts) const {
-    if (this->Stamp() < ts.Stamp()) return true;
-    else if (this->Stamp() == ts.Stamp() && this->SubStamp() < ts.SubStamp()) return true;
-    else return false;
-  }
-
-  ///implementation of equality operator
-  bool IOVTimeStamp::operator==(const IOVTimeStamp& ts) const {
-    if ( fStamp == ts.Stamp() && fSubStamp == ts.SubStamp() ) return true;
-    return false;
-  }
-
-  ///remaining comparison operators implemented in terms of == and <
-  bool IOVTimeStamp::operator!=(const IOVTimeStamp& ts) const {
-    return !( *this == ts);
-  }
-
-  bool IOVTimeStamp::operator<=(const IOVTimeStamp& ts) const {
-    if ( *this < ts || *this == ts) return true;
-    else return false;
-  }
-
-  bool IOVTimeStamp::operator>=(const IOVTimeStamp& ts) const {
-    if ( !( *this < ts) ) return true;
-    else return false;
-  }
-
-  bool IOVTimeStamp::operator>(const IOVTimeStamp& ts) const {
-    if ( !( *this <= ts) ) return true;
-    else return false;
-  }
 }
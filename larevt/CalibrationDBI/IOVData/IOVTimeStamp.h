@@ -14,6 +14,8 @@
 #ifndef IOVDATA_IOVTIMESTAMP_H
 #define IOVDATA_IOVTIMESTAMP_H
 
+#include "IOVDataConstants.h"
+#include <limits>
 #include <string>
 
 namespace lariov {
@@ -28,7 +30,7 @@ namespace lariov {
       ///Constructor
       IOVTimeStamp(unsigned long stamp, unsigned int substamp = 0) :
         fStamp(stamp), fSubStamp(substamp) {
-	this->CalcDBStamp();
+	this->CheckSubStamp();
       }
 
       ///Default destructor
@@ -36,41 +38,43 @@ namespace lariov {
 
       unsigned long Stamp() const { return fStamp; }
       unsigned long SubStamp() const { return fSubStamp; }
-      const std::string& DBStamp() const { return fDBStamp; }
-
-      void SetStamp(unsigned long stamp, unsigned int substamp = 0) {fStamp = stamp; fSubStamp = substamp; this->CalcDBStamp();}
-
 
       /**
-        This function combines the stamp and substamp into a unique string to be used
-	as a database timestamp.
+        Stamp and substamp combined into a unique string to be used as a
+	database timestamp, <stamp>.<substamp> with a six-digit substamp.
+	Built on each call: only needed for queries, file names and messages.
       */
-      void CalcDBStamp();
+      std::string DBStamp() const;
+
+      void SetStamp(unsigned long stamp, unsigned int substamp = 0) {fStamp = stamp; fSubStamp = substamp; this->CheckSubStamp();}
 
       static IOVTimeStamp GetFromString(const std::string& ts);
-      static IOVTimeStamp MinTimeStamp();
-      static IOVTimeStamp MaxTimeStamp();
+      static IOVTimeStamp MinTimeStamp() { return IOVTimeStamp(0,0); }
+      static IOVTimeStamp MaxTimeStamp() { return IOVTimeStamp(std::numeric_limits<unsigned long>::max(), kMAX_SUBSTAMP_VALUE); }
 
 
       ///comparison operators
-      bool operator<(const IOVTimeStamp& ts) const;
-      bool operator<=(const IOVTimeStamp& ts) const;
-      bool operator>=(const IOVTimeStamp& ts) const;
-      bool operator>(const IOVTimeStamp& ts) const;
-
-      bool operator==(const IOVTimeStamp& ts) const;
-      bool operator!=(const IOVTimeStamp& ts) const;
+      bool operator<(const IOVTimeStamp& ts) const {
+        return fStamp < ts.fStamp || (fStamp == ts.fStamp && fSubStamp < ts.fSubStamp);
+      }
+      bool operator<=(const IOVTimeStamp& ts) const { return !(ts < *this); }
+      bool operator>=(const IOVTimeStamp& ts) const { return !(*this < ts); }
+      bool operator>(const IOVTimeStamp& ts) const  { return ts < *this; }
 
-      ///assignment operator
-      IOVTimeStamp& operator=( const IOVTimeStamp& ts);
+      bool operator==(const IOVTimeStamp& ts) const { return fStamp == ts.fStamp && fSubStamp == ts.fSubStamp; }
+      bool operator!=(const IOVTimeStamp& ts) const { return !(*this == ts); }
 
 
     protected:
 
+      void CheckSubStamp() const {
+        if (fSubStamp > kMAX_SUBSTAMP_VALUE) ThrowBadSubStamp();
+      }
+
+      [[noreturn]] static void ThrowBadSubStamp();
+
       unsigned long fStamp;
       unsigned int fSubStamp;
-
-      std::string fDBStamp;
   };
 }
 #endif
@@ -15,6 +15,7 @@
 #define IOVDATA_PMTGAIN_H
 
 #include "ChData.h"
+#include "SnapshotFields.h"
 #include "CalibrationExtraInfo.h"
 
 namespace lariov {
@@ -27,28 +28,43 @@ namespace lariov {
 
       /// Constructor
       PmtGain(unsigned int ch) :
-        ChData(ch),
-	fExtraInfo("PmtGain") {}
+        ChData(ch) {}
 
       /// Default destructor
       ~PmtGain() {}
 
       float Gain()    const { return fGain; }
       float GainErr() const { return fGainErr; }
-      CalibrationExtraInfo const& ExtraInfo() const { return fExtraInfo; }
+      CalibrationExtraInfo const& ExtraInfo() const { return fExtraInfo ? *fExtraInfo : NoExtraInfo(); }
 
       void SetGain(float v)    { fGain    = v; }
       void SetGainErr(float v) { fGainErr = v; }
       void SetExtraInfo(CalibrationExtraInfo const& info)
-      { fExtraInfo = info; }
+      { fExtraInfo = CalibrationExtraInfo::Share(info, NoExtraInfo()); }
+
+      /// The extra info of rows without extra data, shared by all of them
+      static CalibrationExtraInfo const& NoExtraInfo() {
+        static const CalibrationExtraInfo info("PmtGain");
+        return info;
+      }
 
     private:
 
       float fGain;
       float fGainErr;
-      CalibrationExtraInfo fExtraInfo;
+      std::shared_ptr<const CalibrationExtraInfo> fExtraInfo;  //Null for the usual rows without extra data
 
   }; // end class
+
+  /// Fields of a PMT gain row kept as columns by Snapshot
+  template <>
+  struct SnapshotFields<PmtGain> {
+    enum Field_t { kGain, kGainErr, kNFields };
+    static constexpr float (PmtGain::*Getters[kNFields])() const = {
+      &PmtGain::Gain,
+      &PmtGain::GainErr
+    };
+  };
 } // end namespace lariov
 
 #endif
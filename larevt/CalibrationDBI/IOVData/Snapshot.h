@@ -15,9 +15,13 @@
 #define IOVDATA_SNAPSHOT_H
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <vector>
 #include "IOVTimeStamp.h"
 #include "ChData.h"
+#include "SnapshotFields.h"
 #include <sstream>
 #include "IOVDataError.h"
 #include "IOVDataConstants.h"
@@ -34,7 +38,7 @@ namespace lariov {
 
       /// Default constructor
       Snapshot() :
-        fStart(0,0), fEnd(0,0) {}
+        fStart(0,0), fEnd(0,0), fColumns(std::make_shared<LazyColumns>()), fAllChanged(true) {}
 
       /// Default destructor
       ~Snapshot(){}
@@ -47,10 +51,62 @@ namespace lariov {
 
       bool  IsValid(const IOVTimeStamp& ts) const;
 
-      size_t NChannels() const {return fData.size();}
+      size_t NChannels() const {return fLazy ? fLazy->Channels().size() : fData.size();}
 
+      /// The rows, in channel order; empty for a lazy snapshot, whose rows are only reached through GetRow()
       const std::vector<T>& Data() const {return fData;}
 
+      /**
+         Serve the given channels, in increasing order, without building their
+         rows: the row of channels[i] is made by make(i) when first accessed,
+         from any thread, and kept.  The channel list is shared, not copied, e.g.
+         with the payload it comes from.  Replaces the rows of the snapshot;
+         copies of the snapshot share the rows made.  Changing a row makes all of them.
+      */
+      void SetLazyRows(std::shared_ptr<const std::vector<unsigned int>> channels, std::function<T(size_t)> make);
+
+      /// True if the rows are made on first access, see SetLazyRows()
+      bool IsLazy() const {return fLazy != nullptr;}
+
+      /// Number of rows made so far by a lazy snapshot, or all of them
+      size_t NRowsMade() const {return fLazy ? fLazy->NMade() : fData.size();}
+
+      /**
+         Channels of all rows, in increasing order, and the values of one field
+         of T for the same channels: contiguous arrays for loops over all the
+         channels.  Only for row types with SnapshotFields.  The columns are
+         made from the rows on first use, from any thread, and kept until the
+         rows change.  A lazy snapshot has the channels but no field columns.
+      */
+      const std::vector<unsigned int>& Channels() const {return fLazy ? fLazy->Channels() : this->Columns().fChannels;}
+      FieldView Field(size_t field) const {
+        const ColumnTable& columns = this->Columns();
+        if (columns.fValues.empty()) return FieldView();
+        const float* values = columns.fValues.data() + field*columns.fChannels.size();
+        return FieldView(values, values + columns.fChannels.size());
+      }
+
+      /// True if the columns were made since the last change of the rows
+      bool HasColumns() const {return fColumns && fColumns->Made();}
+
+      /**
+         Fill values[i] with the field of channels[i], for the n channels, from
+         the columns, or from the rows of a lazy snapshot; requests in
+         increasing channel order are fastest.  Throws IOVDataError if a
+         channel is not found.
+      */
+      void FillField(size_t field, const unsigned int* channels, size_t n, float* values) const;
+
+      /// True unless the snapshot was patched from the previous one, in which case only ChangedChannels() differ
+      bool AllChanged() const {return fAllChanged;}
+
+      /// Channels added, modified or removed with respect to the previous snapshot, in increasing order
+      const std::vector<unsigned int>& ChangedChannels() const {return fChanged;}
+
+      void SetChangedChannels(std::vector<unsigned int> channels) {
+        fChanged = std::move(channels);
+        fAllChanged = false;
+      }
 
 
       /// Only included with class if T has base class ChData
@@ -58,6 +114,7 @@ namespace lariov {
                 typename std::enable_if<std::is_base_of<ChData, U>::value, int>::type = 0>
       bool HasChannel(unsigned int ch) const {
 
+        if (fLazy) return fLazy->Find(ch) != fLazy->Channels().size();
 	typename std::vector<T>::const_iterator it = std::lower_bound(fData.begin(), fData.end(), ch);
 	if ( it == fData.end() || it->Channel() != ch) {
 	  return false;
@@ -69,13 +126,15 @@ namespace lariov {
                 typename std::enable_if<std::is_base_of<ChData, U>::value, int>::type = 0>
       const T& GetRow(unsigned int ch) const {
 
+        if (fLazy) {
+          const size_t i = fLazy->Find(ch);
+          if (i == fLazy->Channels().size()) ThrowChannelNotFound(ch);
+          return fLazy->Row(i);
+        }
+
         typename std::vector<T>::const_iterator it = std::lower_bound(fData.begin(), fData.end(), ch);
 
-	if ( it == fData.end() || it->Channel() != ch ) {
-          std::string msg("Channel not found: ");
-	  msg += std::to_string(ch);
-	  throw IOVDataError(msg);
-	}
+	if ( it == fData.end() || it->Channel() != ch ) ThrowChannelNotFound(ch);
 
 	return *it;
       }
@@ -83,22 +142,170 @@ namespace lariov {
       template< class U = T,
       		typename std::enable_if<std::is_base_of<ChData, U>::value, int>::type = 0>
       void AddOrReplaceRow(const T& data) {
+        this->MakeAllRows();
         typename std::vector<T>::iterator it = std::lower_bound(fData.begin(), fData.end(), data.Channel());
         if (it == fData.end() || data.Channel() != it->Channel() ) {
-	  bool sort = ( !(fData.empty()) && data < fData.back());
-	  fData.push_back(data);
-	  if (sort) std::sort(fData.begin(), fData.end());
+	  fData.insert(it, data);
         }
         else {
 	  *it = data;
 	}
+        this->ClearColumns();
+      }
+
+      /// Add many rows at once; taken over as they are when the snapshot is empty and they are in strict channel order
+      template< class U = T,
+      		typename std::enable_if<std::is_base_of<ChData, U>::value, int>::type = 0>
+      void AddOrReplaceRows(std::vector<T>&& rows) {
+        bool ordered = std::adjacent_find(rows.begin(), rows.end(),
+                                          [](const T& a, const T& b){ return !(a < b); }) == rows.end();
+        this->MakeAllRows();
+        if (fData.empty() && ordered) fData = std::move(rows);
+        else for (const T& row : rows) this->AddOrReplaceRow(row);
+        this->ClearColumns();
+      }
+
+      template< class U = T,
+      		typename std::enable_if<std::is_base_of<ChData, U>::value, int>::type = 0>
+      void RemoveRow(unsigned int ch) {
+        this->MakeAllRows();
+        typename std::vector<T>::iterator it = std::lower_bound(fData.begin(), fData.end(), ch);
+        if (it != fData.end() && it->Channel() == ch) fData.erase(it);
+        this->ClearColumns();
       }
 
     private:
 
+      /// Rows of a lazy snapshot, each made once by the first thread to access it
+      class LazyRows {
+
+        public:
+
+          LazyRows(std::shared_ptr<const std::vector<unsigned int>> channels, std::function<T(size_t)> make) :
+            fChannels(std::move(channels)), fMake(std::move(make)),
+            fRows(new std::atomic<const T*>[fChannels->size()]()) {}
+
+          LazyRows(const LazyRows&) = delete;
+          LazyRows& operator=(const LazyRows&) = delete;
+
+          ~LazyRows() {
+            for (size_t i = 0; i < fChannels->size(); ++i) delete fRows[i].load(std::memory_order_relaxed);
+          }
+
+          const std::vector<unsigned int>& Channels() const {return *fChannels;}
+
+          /// Index of channel ch, or the number of channels if it has no row
+          size_t Find(unsigned int ch) const {
+            std::vector<unsigned int>::const_iterator it = std::lower_bound(fChannels->begin(), fChannels->end(), ch);
+            return (it != fChannels->end() && *it == ch) ? it - fChannels->begin() : fChannels->size();
+          }
+
+          const T& Row(size_t i) const {
+            const T* row = fRows[i].load(std::memory_order_acquire);
+            if (row) return *row;
+            std::unique_ptr<const T> made(new T(fMake(i)));
+            //another thread may have made the same row meanwhile: the first one stays
+            if (fRows[i].compare_exchange_strong(row, made.get(), std::memory_order_acq_rel)) return *made.release();
+            return *row;
+          }
+
+          size_t NMade() const {
+            size_t n = 0;
+            for (size_t i = 0; i < fChannels->size(); ++i) n += (fRows[i].load(std::memory_order_relaxed) != nullptr);
+            return n;
+          }
+
+        private:
+
+          std::shared_ptr<const std::vector<unsigned int>> fChannels;
+          std::function<T(size_t)>                   fMake;
+          std::unique_ptr<std::atomic<const T*>[]>   fRows;
+      };
+
+      /// Channel column and field columns one after the other
+      struct ColumnTable {
+        std::vector<unsigned int> fChannels;
+        std::vector<float>        fValues;
+      };
+
+      /// Columns of the rows, made once by the first thread to ask for them
+      class LazyColumns {
+
+        public:
+
+          LazyColumns() : fTable(nullptr) {}
+
+          LazyColumns(const LazyColumns&) = delete;
+          LazyColumns& operator=(const LazyColumns&) = delete;
+
+          ~LazyColumns() { delete fTable.load(std::memory_order_relaxed); }
+
+          const ColumnTable& Get(const std::vector<T>& rows) const {
+            const ColumnTable* table = fTable.load(std::memory_order_acquire);
+            if (table) return *table;
+            std::unique_ptr<const ColumnTable> made(new ColumnTable(Build(rows)));
+            //another thread may have made them meanwhile: the first ones stay
+            if (fTable.compare_exchange_strong(table, made.get(), std::memory_order_acq_rel)) return *made.release();
+            return *table;
+          }
+
+          bool Made() const {return fTable.load(std::memory_order_acquire) != nullptr;}
+
+          /// Forget the columns; only while no other thread can use them
+          void Reset() { delete fTable.exchange(nullptr, std::memory_order_acq_rel); }
+
+        private:
+
+          static ColumnTable Build(const std::vector<T>& rows) {
+            ColumnTable table;
+            if constexpr (SnapshotFields<T>::kNFields > 0) {
+              table.fChannels.reserve(rows.size());
+              for (const T& row : rows) table.fChannels.push_back(row.Channel());
+              table.fValues.resize(SnapshotFields<T>::kNFields * rows.size());
+              float* values = table.fValues.data();
+              for (auto getter : SnapshotFields<T>::Getters) {
+                for (const T& row : rows) *values++ = (row.*getter)();
+              }
+            }
+            return table;
+          }
+
+          mutable std::atomic<const ColumnTable*> fTable;
+      };
+
+      [[noreturn]] static void ThrowChannelNotFound(unsigned int ch) {
+        std::string msg("Channel not found: ");
+        msg += std::to_string(ch);
+        throw IOVDataError(msg);
+      }
+
+      /// Turn a lazy snapshot into one holding all its rows
+      void MakeAllRows() {
+        if (!fLazy) return;
+        std::shared_ptr<const LazyRows> lazy = std::move(fLazy);
+        fData.clear();
+        fData.reserve(lazy->Channels().size());
+        for (size_t i = 0; i < lazy->Channels().size(); ++i) fData.push_back(lazy->Row(i));
+      }
+
+      const ColumnTable& Columns() const {
+        static const ColumnTable kNoColumns;
+        return (fLazy || !fColumns) ? kNoColumns : fColumns->Get(fData);
+      }
+
+      /// Drop the columns after a change of the rows; copies sharing them keep theirs
+      void ClearColumns() {
+        if (fColumns && fColumns.use_count() == 1) fColumns->Reset();
+        else fColumns = std::make_shared<LazyColumns>();
+      }
+
       IOVTimeStamp  fStart;
       IOVTimeStamp  fEnd;
       std::vector<T> fData;
+      std::shared_ptr<LazyColumns> fColumns; //Made on first use, shared with copies until the rows change
+      std::shared_ptr<const LazyRows> fLazy; //Rows made on first access instead of fData, if set
+      std::vector<unsigned int> fChanged;
+      bool           fAllChanged;
   };
 
   //=============================================
@@ -107,10 +314,45 @@ namespace lariov {
   template <class T>
   void Snapshot<T>::Clear() {
     fData.clear();
+    fLazy.reset();
+    this->ClearColumns();
+    fChanged.clear();
+    fAllChanged = true;
     fStart  = fEnd = IOVTimeStamp::MaxTimeStamp();
     fStart.SetStamp(fStart.Stamp()-1, fStart.SubStamp());
   }
 
+  template <class T>
+  void Snapshot<T>::FillField(size_t field, const unsigned int* channels, size_t n, float* values) const {
+    const FieldView column = this->Field(field);
+    if (column.empty()) {
+      for (size_t i = 0; i < n; ++i) {
+        values[i] = (this->GetRow(channels[i]).*SnapshotFields<T>::Getters[field])();
+      }
+      return;
+    }
+
+    //channels requested in increasing order are found by searching forward from the last one
+    const std::vector<unsigned int>& all = this->Columns().fChannels;
+    std::vector<unsigned int>::const_iterator first = all.begin();
+    for (size_t i = 0; i < n; ++i) {
+      if (i > 0 && channels[i] < channels[i-1]) first = all.begin();
+      first = std::lower_bound(first, all.end(), channels[i]);
+      if (first == all.end() || *first != channels[i]) {
+        throw IOVDataError("Channel not found: " + std::to_string(channels[i]));
+      }
+      values[i] = column[first - all.begin()];
+    }
+  }
+
+  template <class T>
+  void Snapshot<T>::SetLazyRows(std::shared_ptr<const std::vector<unsigned int>> channels,
+                                std::function<T(size_t)> make) {
+    fData.clear();
+    this->ClearColumns();
+    fLazy = std::make_shared<const LazyRows>(std::move(channels), std::move(make));
+  }
+
   template <class T>
   void Snapshot<T>::SetIoV(const IOVTimeStamp& start, const IOVTimeStamp& end) {
     if (start >= end) {
@@ -0,0 +1,54 @@
+/**
+ * \file SnapshotFields.h
+ *
+ * \ingroup IOVData
+ *
+ * \brief Column layout of the floating point fields of calibration rows
+ */
+
+/** \addtogroup IOVData
+
+    @{*/
+#ifndef IOVDATA_SNAPSHOTFIELDS_H
+#define IOVDATA_SNAPSHOTFIELDS_H
+
+#include <cstddef>
+
+namespace lariov {
+
+  /// Read-only view of a contiguous array of floats, e.g. one field of all the rows of a Snapshot
+  class FieldView {
+
+    public:
+
+      FieldView() : fBegin(nullptr), fEnd(nullptr) {}
+      FieldView(const float* begin, const float* end) : fBegin(begin), fEnd(end) {}
+
+      const float* begin() const {return fBegin;}
+      const float* end() const   {return fEnd;}
+      const float* data() const  {return fBegin;}
+      size_t size() const        {return fEnd - fBegin;}
+      bool empty() const         {return fBegin == fEnd;}
+      float operator[](size_t i) const {return fBegin[i];}
+
+    private:
+
+      const float* fBegin;
+      const float* fEnd;
+  };
+
+  /**
+     \class SnapshotFields
+     Floating point fields of a row type T that a Snapshot<T> also stores as
+     columns, one contiguous array per field.  Specializations define an enum
+     of the fields ending with kNFields, and Getters, the accessor of each
+     field in the same order.  Types without a specialization have no columns.
+  */
+  template <class T>
+  struct SnapshotFields {
+    enum { kNFields = 0 };
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
@@ -3,32 +3,35 @@
 #include "IOVDataConstants.h"
 #include "IOVDataError.h"
 
+namespace {
+
+  //microboone stores timestamp as ns from epoch, so there should be 19 digits.
+  const lariov::DBTimeStamp_t kMinNanoSeconds = 1000000000000000000ULL; //smallest 19-digit number
+  const lariov::DBTimeStamp_t kMaxNanoSeconds = 9999999999999999999ULL; //largest 19-digit number
+  const lariov::DBTimeStamp_t kNanoSecondsPerSecond = 1000000000ULL;
+  const lariov::DBTimeStamp_t kNanoSecondsPerSubStamp = 1000ULL;      //database precision is microseconds
+
+  //shorter values are taken as seconds, up to this many digits
+  const lariov::DBTimeStamp_t kMaxSeconds = 99999ULL;
+}
+
 namespace lariov {
 
   //Do NOT change the following code without very good reason!
   //MicroBooNE and other experiments depend on it!
+  //The arithmetic reproduces the former string handling: a 19-digit time is
+  //cut to its first 16 digits with a decimal point after the 10th, and a
+  //time of fewer than six digits is taken as is.
   IOVTimeStamp TimeStampDecoder::DecodeTimeStamp(DBTimeStamp_t ts) {
 
-    std::string time = std::to_string(ts);
-
-    //microboone stores timestamp as ns from epoch, so there should be 19 digits.
-    if (time.length() == 19) {
-      //make timestamp conform to database precision
-      time = time.substr(0, 10+kMAX_SUBSTAMP_LENGTH);
-
-      //insert decimal point
-      time.insert(10,".");
-
-      //finish construction
-      IOVTimeStamp tmp = IOVTimeStamp::GetFromString(time);
-      return tmp;
+    if (ts >= kMinNanoSeconds && ts <= kMaxNanoSeconds) {
+      return IOVTimeStamp(ts/kNanoSecondsPerSecond, (ts%kNanoSecondsPerSecond)/kNanoSecondsPerSubStamp);
     }
-    else if (time.length() < kMAX_SUBSTAMP_LENGTH && ts!=0) {
-      IOVTimeStamp tmp = IOVTimeStamp::GetFromString(time);
-      return tmp;
+    else if (ts <= kMaxSeconds && ts!=0) {
+      return IOVTimeStamp(ts);
     }
     else {
-      std::string msg = "TimeStampDecoder: I do not know how to convert this timestamp: " + time;
+      std::string msg = "TimeStampDecoder: I do not know how to convert this timestamp: " + std::to_string(ts);
       throw IOVDataError(msg);
     }
   }
@@ -13,6 +13,9 @@
 #include "larcorealg/CoreUtils/UncopiableAndUnmovableClass.h"
 #include "larcoreobj/SimpleTypesAndConstants/RawTypes.h" // raw::ChannelID_t
 
+// C/C++ standard libraries
+#include <cstddef>
+
 
 namespace lariov {
 
@@ -34,6 +37,24 @@ namespace lariov {
       virtual float PedMeanErr(raw::ChannelID_t ch) const = 0;
       virtual float PedRmsErr(raw::ChannelID_t ch) const = 0;
 
+      /**
+        Batch getters: fill values[i] for channels[i], for the n channels given,
+        e.g. once per event for all the channels a module works on.  The
+        defaults call the single-channel getter for each channel.
+      */
+      virtual void FillPedMean(raw::ChannelID_t const* channels, size_t n, float* values) const {
+        for (size_t i = 0; i < n; ++i) values[i] = this->PedMean(channels[i]);
+      }
+      virtual void FillPedRms(raw::ChannelID_t const* channels, size_t n, float* values) const {
+        for (size_t i = 0; i < n; ++i) values[i] = this->PedRms(channels[i]);
+      }
+      virtual void FillPedMeanErr(raw::ChannelID_t const* channels, size_t n, float* values) const {
+        for (size_t i = 0; i < n; ++i) values[i] = this->PedMeanErr(channels[i]);
+      }
+      virtual void FillPedRmsErr(raw::ChannelID_t const* channels, size_t n, float* values) const {
+        for (size_t i = 0; i < n; ++i) values[i] = this->PedRmsErr(channels[i]);
+      }
+
     /* TODO DELME
       /// Update local state of implementation
       virtual bool Update(DBTimeStamp_t ts) = 0;
@@ -13,6 +13,8 @@
 #include "larcorealg/CoreUtils/UncopiableAndUnmovableClass.h"
 #include "larevt/CalibrationDBI/IOVData/CalibrationExtraInfo.h"
 
+#include <cstddef>
+
 namespace lariov {
 
   /**
@@ -34,6 +36,24 @@ namespace lariov {
       virtual float ShapingTime(raw::ChannelID_t ch) const = 0;
       virtual float ShapingTimeErr(raw::ChannelID_t ch) const = 0;
 
+      /**
+        Batch getters: fill values[i] for channels[i], for the n channels given,
+        e.g. once per event for all the channels a module works on.  The
+        defaults call the single-channel getter for each channel.
+      */
+      virtual void FillGain(raw::ChannelID_t const* channels, size_t n, float* values) const {
+        for (size_t i = 0; i < n; ++i) values[i] = this->Gain(channels[i]);
+      }
+      virtual void FillGainErr(raw::ChannelID_t const* channels, size_t n, float* values) const {
+        for (size_t i = 0; i < n; ++i) values[i] = this->GainErr(channels[i]);
+      }
+      virtual void FillShapingTime(raw::ChannelID_t const* channels, size_t n, float* values) const {
+        for (size_t i = 0; i < n; ++i) values[i] = this->ShapingTime(channels[i]);
+      }
+      virtual void FillShapingTimeErr(raw::ChannelID_t const* channels, size_t n, float* values) const {
+        for (size_t i = 0; i < n; ++i) values[i] = this->ShapingTimeErr(channels[i]);
+      }
+
       virtual CalibrationExtraInfo const& ExtraInfo(raw::ChannelID_t ch) const = 0;
   };
 }//end namespace lariov
@@ -0,0 +1,69 @@
+#include "ConditionsClock.h"
+#include "DBFetchPool.h"
+#include "larevt/CalibrationDBI/IOVData/TimeStampDecoder.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include <exception>
+
+namespace lariov {
+
+  void ConditionsClock::Watch(const std::string& name, IsCurrent_t isCurrent, Update_t update,
+                              Prefetch_t prefetch /*= nullptr*/) {
+    fFolders.push_back(Folder{name, std::move(isCurrent), std::move(update), std::move(prefetch)});
+  }
+
+  void ConditionsClock::WatchEvents(Update_t callback) {
+    fEventCallbacks.push_back(std::move(callback));
+  }
+
+  size_t ConditionsClock::Tick(DBTimeStamp_t ts) {
+
+    for (auto const& callback : fEventCallbacks) callback(ts);
+
+    if (fFolders.empty() || ts == fLastTime.load(std::memory_order_acquire)) return 0;
+
+    const IOVTimeStamp time = TimeStampDecoder::DecodeTimeStamp(ts);
+
+    std::vector<const Folder*> stale;
+    for (auto const& folder : fFolders) {
+      if (!folder.fIsCurrent(time)) stale.push_back(&folder);
+      else if (folder.fPrefetch) folder.fPrefetch(time);
+    }
+
+    if (stale.size() == 1) {
+      stale.front()->fUpdate(ts);
+    }
+    else if (stale.size() > 1) {
+      mf::LogInfo("ConditionsClock") << "Updating " << stale.size() << " conditions folders at "
+                                     << time.DBStamp();
+
+      //the others go to the fetch pool while the first folder is updated on this
+      //thread; every update is waited for before an error is passed on
+      std::vector<DBFetchPool::Future<void>> pending;
+      for (size_t i=1; i < stale.size(); ++i) {
+        const Update_t& update = stale[i]->fUpdate;
+        pending.push_back(DBFetchPool::Instance().Submit([&update, ts]() { update(ts); }));
+      }
+      std::exception_ptr error;
+      try {
+        stale.front()->fUpdate(ts);
+      }
+      catch (...) {
+        error = std::current_exception();
+      }
+      for (auto& update : pending) {
+        try {
+          update.get();
+        }
+        catch (...) {
+          if (!error) error = std::current_exception();
+        }
+      }
+      if (error) std::rethrow_exception(error);
+    }
+
+    fLastTime.store(ts, std::memory_order_release);
+    return stale.size();
+  }
+
+}//end namespace lariov
@@ -0,0 +1,82 @@
+/**
+ * \file ConditionsClock.h
+ *
+ * \ingroup WebDBI
+ *
+ * \brief Class def header for a class ConditionsClock
+ */
+
+/** \addtogroup WebDBI
+
+    @{*/
+#ifndef WEBDBI_CONDITIONSCLOCK_H
+#define WEBDBI_CONDITIONSCLOCK_H
+
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Interface/CalibrationDBIFwd.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace lariov {
+
+  /**
+     \class ConditionsClock
+     Keeps a set of conditions folders current with the event time.
+
+     Each event time is decoded once for all the folders.  Only the folders
+     whose data do not cover it are updated, concurrently on the DBFetchPool
+     when there are several of them, so an IOV boundary costs the slowest
+     fetch rather than the sum of them.  Folders that are still current may
+     get a prefetch callback instead, to fetch their next IOV ahead of time.
+     Events at the same time as the previous one cost a single comparison.
+     Folders and callbacks are registered before the first event, e.g. from
+     service constructors.
+  */
+  class ConditionsClock {
+
+    public:
+
+      /// Returns true if the folder data are valid at the given time
+      using IsCurrent_t = std::function<bool(const IOVTimeStamp&)>;
+
+      /// Brings the folder data up to date for the given event time
+      using Update_t = std::function<void(DBTimeStamp_t)>;
+
+      /// Gets the next IOV of a current folder ready if the event time is close to its end; must be cheap otherwise
+      using Prefetch_t = std::function<void(const IOVTimeStamp&)>;
+
+      ConditionsClock() : fLastTime(0) {}
+
+      ConditionsClock(const ConditionsClock&) = delete;
+      ConditionsClock& operator=(const ConditionsClock&) = delete;
+
+      /// Keep a folder current; update is called only when isCurrent says the data are stale, prefetch (if any) otherwise
+      void Watch(const std::string& name, IsCurrent_t isCurrent, Update_t update, Prefetch_t prefetch = nullptr);
+
+      /// Call back at every event, before any folder is updated
+      void WatchEvents(Update_t callback);
+
+      /// Bring the watched folders up to date for this event time; returns the number updated
+      size_t Tick(DBTimeStamp_t ts);
+
+      size_t NFolders() const { return fFolders.size(); }
+
+    private:
+
+      struct Folder {
+        std::string fName;
+        IsCurrent_t fIsCurrent;
+        Update_t    fUpdate;
+        Prefetch_t  fPrefetch;
+      };
+
+      std::vector<Folder>   fFolders;
+      std::vector<Update_t> fEventCallbacks;
+      std::atomic<DBTimeStamp_t> fLastTime;   //All folders were current at this time; 0 before the first event
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
@@ -0,0 +1,50 @@
+#include "DBChannelFilter.h"
+#include "WebError.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace lariov {
+
+  void DBChannelFilter::AddRange(DBChannelID_t first, DBChannelID_t last) {
+
+    if (last < first) {
+      throw WebError("DBChannelFilter: range " + std::to_string(first) + "-" + std::to_string(last)
+                     + " ends before it starts!");
+    }
+
+    //insert in order, then merge the ranges overlapping or touching their neighbours
+    fRanges.insert(std::lower_bound(fRanges.begin(), fRanges.end(), Range_t(first, last)), Range_t(first, last));
+    std::vector<Range_t> merged;
+    merged.reserve(fRanges.size());
+    for (const Range_t& range : fRanges) {
+      if (!merged.empty() && (unsigned long long)range.first <= merged.back().second + 1ULL) {
+        merged.back().second = std::max(merged.back().second, range.second);
+      }
+      else merged.push_back(range);
+    }
+    fRanges = std::move(merged);
+  }
+
+  bool DBChannelFilter::Contains(DBChannelID_t ch) const {
+
+    if (fRanges.empty()) return true;
+
+    //last range starting at or before ch
+    std::vector<Range_t>::const_iterator it = std::upper_bound(fRanges.begin(), fRanges.end(), ch,
+      [](DBChannelID_t c, const Range_t& range) { return c < range.first; });
+    return it != fRanges.begin() && ch <= std::prev(it)->second;
+  }
+
+  std::string DBChannelFilter::ToString() const {
+
+    std::string text;
+    for (const Range_t& range : fRanges) {
+      if (!text.empty()) text += ',';
+      text += std::to_string(range.first);
+      if (range.second != range.first) text += '-' + std::to_string(range.second);
+    }
+    return text;
+  }
+
+}//end namespace lariov
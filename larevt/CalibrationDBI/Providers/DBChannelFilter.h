@@ -0,0 +1,58 @@
+/**
+ * \file DBChannelFilter.h
+ *
+ * \ingroup WebDBI
+ *
+ * \brief Class def header for a class DBChannelFilter
+ */
+
+/** \addtogroup WebDBI
+
+    @{*/
+#ifndef WEBDBI_DBCHANNELFILTER_H
+#define WEBDBI_DBCHANNELFILTER_H
+
+#include "larevt/CalibrationDBI/Interface/CalibrationDBIFwd.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lariov {
+
+  /**
+     \class DBChannelFilter
+     The channels a job needs from a folder, as ranges of channels; a filter
+     without any range lets every channel through.  Ranges are kept sorted,
+     with overlapping and adjacent ones merged.
+  */
+  class DBChannelFilter {
+
+    public:
+
+      using Range_t = std::pair<DBChannelID_t, DBChannelID_t>;
+
+      /// Add the channels from first to last, both included
+      void AddRange(DBChannelID_t first, DBChannelID_t last);
+      void AddChannel(DBChannelID_t ch) {this->AddRange(ch, ch);}
+
+      /// True if no range was given, i.e. all channels pass
+      bool Empty() const {return fRanges.empty();}
+
+      bool Contains(DBChannelID_t ch) const;
+
+      const std::vector<Range_t>& Ranges() const {return fRanges;}
+
+      /// Comma separated ranges "first-last" and single channels, e.g. "0-2559,4800"; empty without ranges
+      std::string ToString() const;
+
+      bool operator==(const DBChannelFilter& other) const {return fRanges == other.fRanges;}
+      bool operator!=(const DBChannelFilter& other) const {return fRanges != other.fRanges;}
+
+    private:
+
+      std::vector<Range_t> fRanges;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
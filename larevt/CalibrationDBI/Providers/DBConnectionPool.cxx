@@ -0,0 +1,117 @@
+#include "DBConnectionPool.h"
+
+#include <chrono>
+
+namespace {
+
+  /// "http://host:port" of a url
+  std::string HostOf(const std::string& url) {
+    size_t start = url.find("://");
+    start = (start == std::string::npos) ? 0 : start + 3;
+    return url.substr(0, url.find('/', start));
+  }
+
+  void LockShare(CURL*, curl_lock_data data, curl_lock_access, void* userptr) {
+    static_cast<std::mutex*>(userptr)[data].lock();
+  }
+
+  void UnlockShare(CURL*, curl_lock_data data, void* userptr) {
+    static_cast<std::mutex*>(userptr)[data].unlock();
+  }
+}
+
+namespace lariov {
+
+  DBConnectionPool::State_t::State_t() : fMaxPerHost(6), fKeepAlive(true), fNHandles(0) {
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    fShare = curl_share_init();
+    curl_share_setopt(fShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(fShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    curl_share_setopt(fShare, CURLSHOPT_LOCKFUNC, LockShare);
+    curl_share_setopt(fShare, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+    curl_share_setopt(fShare, CURLSHOPT_USERDATA, fShareMutex);
+  }
+
+  DBConnectionPool::State_t& DBConnectionPool::State() {
+    static State_t* state = new State_t;
+    return *state;
+  }
+
+  DBConnectionPool::Connection DBConnectionPool::Get(const std::string& url, int timeout) {
+
+    State_t& state = State();
+    const std::string host = HostOf(url);
+    CURL* handle = nullptr;
+    {
+      std::unique_lock<std::mutex> lock(state.fMutex);
+      Host_t& entry = state.fHosts[host];
+      if (!state.fReleased.wait_for(lock, std::chrono::seconds(timeout), [&state, &entry]() {
+            return !entry.fIdle.empty() || entry.fNBusy < state.fMaxPerHost;
+          })) {
+        return Connection(host, nullptr);
+      }
+      if (!entry.fIdle.empty()) {
+        handle = entry.fIdle.back();
+        entry.fIdle.pop_back();
+      }
+      else {
+        handle = curl_easy_init();
+        if (!handle) return Connection(host, nullptr);
+        ++state.fNHandles;
+      }
+      ++entry.fNBusy;
+    }
+
+    curl_easy_setopt(handle, CURLOPT_SHARE, state.fShare);
+    return Connection(host, handle);
+  }
+
+  void DBConnectionPool::Release(const std::string& host, CURL* handle) {
+
+    State_t& state = State();
+    curl_easy_reset(handle); //forgets the options, keeps the connection
+
+    std::lock_guard<std::mutex> lock(state.fMutex);
+    Host_t& entry = state.fHosts[host];
+    --entry.fNBusy;
+    if (state.fKeepAlive && entry.fNBusy + entry.fIdle.size() < state.fMaxPerHost) {
+      entry.fIdle.push_back(handle);
+    }
+    else {
+      curl_easy_cleanup(handle);
+    }
+    state.fReleased.notify_all();
+  }
+
+  void DBConnectionPool::SetMaxPerHost(size_t n) {
+    State_t& state = State();
+    std::lock_guard<std::mutex> lock(state.fMutex);
+    state.fMaxPerHost = (n > 0) ? n : 1;
+    state.fReleased.notify_all();
+  }
+
+  size_t DBConnectionPool::MaxPerHost() {
+    State_t& state = State();
+    std::lock_guard<std::mutex> lock(state.fMutex);
+    return state.fMaxPerHost;
+  }
+
+  void DBConnectionPool::SetKeepAlive(bool keep) {
+    State_t& state = State();
+    std::lock_guard<std::mutex> lock(state.fMutex);
+    state.fKeepAlive = keep;
+    if (keep) return;
+    for (auto& entry : state.fHosts) {
+      for (CURL* handle : entry.second.fIdle) curl_easy_cleanup(handle);
+      entry.second.fIdle.clear();
+    }
+  }
+
+  size_t DBConnectionPool::NHandles() {
+    State_t& state = State();
+    std::lock_guard<std::mutex> lock(state.fMutex);
+    return state.fNHandles;
+  }
+
+}//end namespace lariov
@@ -0,0 +1,110 @@
+/**
+ * \file DBConnectionPool.h
+ *
+ * \ingroup WebDBI
+ *
+ * \brief Class def header for a class DBConnectionPool
+ */
+
+/** \addtogroup WebDBI
+
+    @{*/
+#ifndef WEBDBI_DBCONNECTIONPOOL_H
+#define WEBDBI_DBCONNECTIONPOOL_H
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <curl/curl.h>
+
+namespace lariov {
+
+  /**
+     \class DBConnectionPool
+     Keep-alive connections to the conditions servers, shared by every web
+     fetch in the process.
+
+     A fetch borrows a libcurl handle for the server of its url and gives it
+     back when done; the handle keeps its connection open, so the next fetch
+     to that server skips the TCP and TLS setup.  DNS answers and TLS
+     sessions are shared between all handles.  At most MaxPerHost() handles
+     exist for one server: further fetches wait for one to be given back, for
+     at most the timeout of the fetch.
+  */
+  class DBConnectionPool {
+
+    public:
+
+      /// A handle borrowed from the pool, given back when it goes out of scope
+      class Connection {
+
+        public:
+
+          Connection(Connection&& other) : fHost(std::move(other.fHost)), fHandle(other.fHandle) {
+            other.fHandle = nullptr;
+          }
+          Connection(const Connection&) = delete;
+          Connection& operator=(const Connection&) = delete;
+          Connection& operator=(Connection&&) = delete;
+
+          ~Connection() { if (fHandle) DBConnectionPool::Release(fHost, fHandle); }
+
+          /// The libcurl handle, with default options; null if none could be made
+          CURL* Handle() const { return fHandle; }
+
+        private:
+
+          friend class DBConnectionPool;
+
+          Connection(const std::string& host, CURL* handle) : fHost(host), fHandle(handle) {}
+
+          std::string fHost;
+          CURL*       fHandle;
+      };
+
+      /// Borrow a handle for the server of url, waiting up to timeout seconds if all of its handles are busy;
+      /// the handle is null if none was given back in time
+      static Connection Get(const std::string& url, int timeout);
+
+      /// Most handles for one server; 6 by default
+      static void SetMaxPerHost(size_t n);
+      static size_t MaxPerHost();
+
+      /// With keep-alive off, every fetch opens a new connection
+      static void SetKeepAlive(bool keep);
+
+      /// Number of handles made so far, each with a connection of its own
+      static size_t NHandles();
+
+    private:
+
+      static void Release(const std::string& host, CURL* handle);
+
+      struct Host_t {
+        size_t             fNBusy = 0;
+        std::vector<CURL*> fIdle;
+      };
+
+      /// Handles and shared caches; never destroyed, as fetches may still run at exit
+      struct State_t {
+        State_t();
+
+        std::mutex                    fMutex;
+        std::condition_variable       fReleased;
+        std::map<std::string, Host_t> fHosts;      //By scheme, host and port
+        size_t                        fMaxPerHost;
+        bool                          fKeepAlive;
+        size_t                        fNHandles;
+        CURLSH*                       fShare;
+        std::mutex                    fShareMutex[CURL_LOCK_DATA_LAST];
+      };
+
+      static State_t& State();
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
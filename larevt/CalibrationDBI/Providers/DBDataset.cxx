@@ -0,0 +1,739 @@
+#include "DBDataset.h"
+#include "WebError.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+  //Binary layout: fixed header, column schema, channel array and one array per
+  //column.  Every array starts on an 8-byte boundary so that a file can be mapped
+  //and read in place.  Values are written in the byte order of the host, which is
+  //recorded in the header and checked on reading.
+  const char          kMagic[8]  = {'L','A','R','I','O','V','D','S'};
+  const std::uint32_t kVersion   = 2; //version 1 had no array columns, and is still read
+  const std::uint32_t kByteOrder = 0x01020304;
+
+  template <class T>
+  void Put(std::string& buffer, T value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  void Align(std::string& buffer) {
+    buffer.append((8 - buffer.size()%8)%8, '\0');
+  }
+
+  class Reader {
+
+    public:
+
+      Reader(const char* buffer, size_t size) :
+        fBegin(buffer), fPos(buffer), fEnd(buffer + size) {}
+
+      const char* Take(size_t n) {
+        if (n > (size_t)(fEnd - fPos)) throw lariov::WebError("DBDataset: truncated buffer!");
+        const char* p = fPos;
+        fPos += n;
+        return p;
+      }
+
+      template <class T>
+      T Get() {
+        T value;
+        std::memcpy(&value, this->Take(sizeof(T)), sizeof(T));
+        return value;
+      }
+
+      void Align() {
+        this->Take((8 - (fPos - fBegin)%8)%8);
+      }
+
+    private:
+
+      const char* fBegin;
+      const char* fPos;
+      const char* fEnd;
+  };
+
+  /**
+     Point at n values of type T in the buffer when it outlives the dataset and is aligned
+     for them; otherwise copy them into copy and return null
+  */
+  template <class T>
+  const T* InPlace(Reader& in, size_t n, bool in_place, std::vector<T>& copy) {
+    static_assert(sizeof(T) == 8, "binary datasets hold 64-bit numbers");
+    if (n > std::numeric_limits<size_t>::max()/sizeof(T)) throw lariov::WebError("DBDataset: truncated buffer!");
+    const char* p = in.Take(n*sizeof(T));
+    if (in_place && reinterpret_cast<std::uintptr_t>(p) % alignof(T) == 0) return reinterpret_cast<const T*>(p);
+    copy.resize(n);
+    if (n > 0) std::memcpy(copy.data(), p, n*sizeof(T));
+    return nullptr;
+  }
+
+  /// Read-only mapping of a whole file, released on destruction
+  class MappedFile {
+
+    public:
+
+      explicit MappedFile(const std::string& path) : fData(nullptr), fSize(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw lariov::WebError("DBDataset: cannot open " + path + ": " + std::strerror(errno));
+
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+          close(fd);
+          throw lariov::WebError("DBDataset: cannot read " + path);
+        }
+        fSize = info.st_size;
+        if (fSize == 0) {
+          close(fd);
+          return;
+        }
+
+        void* map = mmap(nullptr, fSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) throw lariov::WebError("DBDataset: cannot map " + path + ": " + std::strerror(errno));
+        madvise(map, fSize, MADV_WILLNEED);
+        fData = (const char*)map;
+      }
+
+      ~MappedFile() { if (fData) munmap((void*)fData, fSize); }
+
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+
+      const char* Data() const { return fData; }
+      size_t Size() const { return fSize; }
+
+    private:
+
+      const char* fData;
+      size_t      fSize;
+  };
+
+  bool Equals(const char* begin, const char* end, const char* word) {
+    size_t n = std::strlen(word);
+    return (size_t)(end - begin) == n && std::memcmp(begin, word, n) == 0;
+  }
+
+  /// Integer value of a field; like strtol, garbage reads as 0 and trailing characters are ignored
+  long ToLong(const char* begin, const char* end) {
+    while (begin != end && std::isspace((unsigned char)*begin)) ++begin;
+    if (begin != end && *begin == '+') ++begin;
+    long value = 0;
+    std::from_chars(begin, end, value);
+    return value;
+  }
+
+  /// Floating point value of a field
+  double ToDouble(const char* begin, const char* end) {
+
+    //Fast path for plain decimals: with at most 15 significant digits and a power of ten
+    //that is itself exact, a single multiplication or division is correctly rounded
+    static const double kPow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char* p = begin;
+    while (p != end && std::isspace((unsigned char)*p)) ++p;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    std::uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    const char* first = p;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+      if (mantissa != 0 || *p != '0') ++digits;
+      mantissa = mantissa*10 + (*p - '0');
+    }
+    bool has_digits = (p != first);
+    if (p != end && *p == '.') {
+      for (first = ++p; p != end && *p >= '0' && *p <= '9'; ++p) {
+        if (mantissa != 0 || *p != '0') ++digits;
+        mantissa = mantissa*10 + (*p - '0');
+        --exponent;
+      }
+      has_digits = has_digits || (p != first);
+    }
+    if (has_digits && p != end && (*p == 'e' || *p == 'E')) {
+      const char* q = p + 1;
+      if (q != end && *q == '+') ++q;
+      int e = 0;
+      auto res = std::from_chars(q, end, e);
+      if (res.ec == std::errc() && res.ptr != q) {
+        exponent += e;
+        p = res.ptr;
+      }
+    }
+    while (p != end && std::isspace((unsigned char)*p)) ++p;
+    if (has_digits && p == end && digits <= 15 && exponent >= -22 && exponent <= 22) {
+      double value = (double)mantissa;
+      value = (exponent < 0) ? value/kPow10[-exponent] : value*kPow10[exponent];
+      return negative ? -value : value;
+    }
+
+    //everything else (long mantissas, inf, nan, hex...) goes through strtod on a terminated copy
+    char buffer[64];
+    size_t n = end - begin;
+    if (n >= sizeof(buffer)) return std::strtod(std::string(begin, end).c_str(), nullptr);
+    std::memcpy(buffer, begin, n);
+    buffer[n] = '\0';
+    return std::strtod(buffer, nullptr);
+  }
+
+  void Trim(const char*& begin, const char*& end) {
+    while (begin != end && std::isspace((unsigned char)*begin)) ++begin;
+    while (end != begin && std::isspace((unsigned char)*(end-1))) --end;
+  }
+}
+
+namespace lariov {
+
+  DBDataset::DBDataset(const IOVTimeStamp& begin, const IOVTimeStamp& end,
+                       const std::vector<std::string>& names,
+                       const std::vector<std::string>& types) :
+    fBegin(begin), fEnd(end), fNames(names), fTypes(types) {
+
+    if (fNames.empty() || fNames.size() != fTypes.size()) {
+      throw WebError("DBDataset: inconsistent column names and types!");
+    }
+
+    fColumns.resize(fNames.size());
+    fColumns[0].fKind = kLongColumn; //channel number
+    for (size_t c=1; c < fColumns.size(); ++c) {
+      fColumns[c].fKind = KindFromType(fTypes[c]);
+      if (fColumns[c].fKind == kArrayColumn) fColumns[c].fArrayOffsets.push_back(0);
+    }
+  }
+
+  DBDataset::ColumnKind DBDataset::KindFromType(const std::string& type) {
+
+    std::string t(type);
+    std::transform(t.begin(), t.end(), t.begin(), [](unsigned char c){ return std::tolower(c); });
+
+    if (t.find("[]") != std::string::npos || t.find("array") != std::string::npos) return kArrayColumn;
+    if (t.find("bool") != std::string::npos) return kBoolColumn;
+    if (t.find("int") != std::string::npos) return kLongColumn;
+    if (t.find("float") != std::string::npos || t.find("real") != std::string::npos ||
+        t.find("double") != std::string::npos || t.find("numeric") != std::string::npos) return kDoubleColumn;
+    return kStringColumn;
+  }
+
+  void DBDataset::AddValue(ColumnData& col, const char* begin, const char* end) {
+    switch (col.fKind) {
+      case kLongColumn :
+        //the db data may be boolean even though the column is declared as an integer
+        if (Equals(begin, end, "True"))       col.fLong.push_back(1);
+        else if (Equals(begin, end, "False")) col.fLong.push_back(0);
+        else col.fLong.push_back(ToLong(begin, end));
+        break;
+      case kDoubleColumn :
+        col.fDouble.push_back(ToDouble(begin, end));
+        break;
+      case kBoolColumn :
+        if (Equals(begin, end, "True") || Equals(begin, end, "1"))       col.fLong.push_back(1);
+        else if (Equals(begin, end, "False") || Equals(begin, end, "0")) col.fLong.push_back(0);
+        else {
+          std::cout<<"(DBDataset) ERROR: Can't identify data: "<<std::string(begin, end)<<" as boolean!"<<std::endl;
+          col.fLong.push_back(0);
+        }
+        break;
+      case kStringColumn :
+        col.fString.emplace_back(begin, end);
+        break;
+      case kArrayColumn :
+        col.fString.emplace_back(begin, end);
+        Trim(begin, end);
+        ParseArray(begin, end, col.fArray);
+        col.fArrayOffsets.push_back(col.fArray.size());
+        break;
+    }
+  }
+
+  bool DBDataset::ParseArray(const char* begin, const char* end, std::vector<double>& out) {
+
+    while (begin != end && std::isspace((unsigned char)*begin)) ++begin;
+    if (begin == end || *begin != '[') return false;
+
+    const char* p = begin + 1;
+    while (p != end) {
+      const char* q = p;
+      while (q != end && *q != ',' && *q != ']') ++q;
+      const char* first = p;
+      const char* last  = q;
+      Trim(first, last);
+      if (first == last) break;
+      out.push_back(ToDouble(first, last));
+      if (q == end || *q == ']') break;
+      p = q + 1;
+    }
+    return true;
+  }
+
+  void DBDataset::AddRow(const char* const* fields) {
+    for (size_t c=0; c < fColumns.size(); ++c) {
+      AddValue(fColumns[c], fields[c], fields[c] + std::strlen(fields[c]));
+    }
+    fChannels.push_back( (DBChannelID_t)fColumns[0].fLong.back() );
+  }
+
+  void DBDataset::Reserve(size_t nrows) {
+    fChannels.reserve(nrows);
+    for (auto& col : fColumns) {
+      switch (col.fKind) {
+        case kLongColumn   :
+        case kBoolColumn   : col.fLong.reserve(nrows);   break;
+        case kDoubleColumn : col.fDouble.reserve(nrows); break;
+        case kStringColumn : col.fString.reserve(nrows); break;
+        case kArrayColumn  :
+          col.fString.reserve(nrows);
+          col.fArrayOffsets.reserve(nrows+1);
+          break;
+      }
+    }
+  }
+
+  void DBDataset::Finalize() {
+
+    if (std::is_sorted(fChannels.begin(), fChannels.end())) return;
+
+    std::vector<size_t> order(fChannels.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+      [this](size_t a, size_t b){ return fChannels[a] < fChannels[b]; });
+
+    auto permute = [&order](auto& v) {
+      if (v.empty()) return;
+      typename std::decay<decltype(v)>::type tmp;
+      tmp.reserve(v.size());
+      for (size_t i : order) tmp.push_back(std::move(v[i]));
+      v.swap(tmp);
+    };
+
+    permute(fChannels);
+    for (auto& col : fColumns) {
+      permute(col.fLong);
+      permute(col.fDouble);
+      permute(col.fString);
+      if (col.fKind != kArrayColumn) continue;
+
+      //array values move as whole rows
+      std::vector<double> values;
+      std::vector<size_t> offsets;
+      values.reserve(col.fArray.size());
+      offsets.reserve(col.fArrayOffsets.size());
+      offsets.push_back(0);
+      for (size_t i : order) {
+        values.insert(values.end(), col.fArray.begin() + col.fArrayOffsets[i],
+                      col.fArray.begin() + col.fArrayOffsets[i+1]);
+        offsets.push_back(values.size());
+      }
+      col.fArray.swap(values);
+      col.fArrayOffsets.swap(offsets);
+    }
+  }
+
+  bool DBDataset::RowDiffers(size_t row, const DBDataset& other, size_t prev_row) const {
+
+    for (size_t c=1; c < fColumns.size(); ++c) {
+      const ColumnData& a = fColumns[c];
+      const ColumnData& b = other.fColumns[c];
+      switch (a.fKind) {
+        case kLongColumn   :
+        case kBoolColumn   : if (a.Longs()[row] != b.Longs()[prev_row]) return true; break;
+        case kDoubleColumn : {
+          const double x = a.Doubles()[row], y = b.Doubles()[prev_row];
+          if (x != y && !(x != x && y != y)) return true; //NaN stays NaN
+          break;
+        }
+        case kStringColumn :
+        case kArrayColumn  : if (a.fString[row] != b.fString[prev_row]) return true; break;
+      }
+    }
+    return false;
+  }
+
+  bool DBDataset::Diff(const DBDataset& previous, std::vector<size_t>& changed_rows,
+                       std::vector<DBChannelID_t>& removed) const {
+
+    changed_rows.clear();
+    removed.clear();
+    if (fNames != previous.fNames || fColumns.size() != previous.fColumns.size()) return false;
+    for (size_t c=0; c < fColumns.size(); ++c) {
+      if (fColumns[c].fKind != previous.fColumns[c].fKind) return false;
+    }
+
+    //both are in channel order: walk them side by side
+    const std::vector<DBChannelID_t>& prev = previous.fChannels;
+    size_t i = 0, j = 0;
+    while (i < fChannels.size() || j < prev.size()) {
+      if ((i > 0 && i < fChannels.size() && fChannels[i] == fChannels[i-1]) ||
+          (j > 0 && j < prev.size() && prev[j] == prev[j-1])) {
+        changed_rows.clear();
+        removed.clear();
+        return false;
+      }
+      if (j == prev.size() || (i < fChannels.size() && fChannels[i] < prev[j])) {
+        changed_rows.push_back(i++);
+      }
+      else if (i == fChannels.size() || prev[j] < fChannels[i]) {
+        removed.push_back(prev[j++]);
+      }
+      else {
+        if (this->RowDiffers(i, previous, j)) changed_rows.push_back(i);
+        ++i;
+        ++j;
+      }
+    }
+    return true;
+  }
+
+  int DBDataset::Row(DBChannelID_t channel) const {
+    auto it = std::lower_bound(fChannels.begin(), fChannels.end(), channel);
+    if (it == fChannels.end() || *it != channel) return -1;
+    return it - fChannels.begin();
+  }
+
+  int DBDataset::Column(const std::string& name) const {
+    for (size_t c=1; c < fNames.size(); ++c) {
+      if (name == fNames[c]) return c;
+    }
+    return -1;
+  }
+
+  size_t DBDataset::CheckedColumn(const std::string& name) const {
+    int col = this->Column(name);
+    if (col < 0) {
+      std::string msg = "Column named " + name + " is not found in the database!";
+      throw WebError(msg);
+    }
+    return col;
+  }
+
+  void DBDataset::CheckKind(size_t col, ColumnKind a, ColumnKind b, const char* what) const {
+    if (fColumns[col].fKind == a || fColumns[col].fKind == b) return;
+    throw WebError("Column named " + fNames[col] + " has type " + fTypes[col] + " and cannot be read as " + what + "!");
+  }
+
+  bool DBDataset::BoolValue(size_t row, size_t col) const {
+    const ColumnData& c = fColumns[col];
+    switch (c.fKind) {
+      case kLongColumn   :
+      case kBoolColumn   : return c.Longs()[row] != 0;
+      case kDoubleColumn : return c.Doubles()[row] != 0.0;
+      case kStringColumn :
+      case kArrayColumn  :
+        if (c.fString[row] == "True") return true;
+        if (c.fString[row] != "False") {
+          std::cout<<"(DBDataset) ERROR: Can't identify data: "<<c.fString[row]<<" as boolean!"<<std::endl;
+        }
+        return false;
+    }
+    return false;
+  }
+
+  long DBDataset::LongValue(size_t row, size_t col) const {
+    const ColumnData& c = fColumns[col];
+    switch (c.fKind) {
+      case kLongColumn   :
+      case kBoolColumn   : return c.Longs()[row];
+      case kDoubleColumn : return (long)c.Doubles()[row];
+      case kStringColumn :
+      case kArrayColumn  :
+        if (c.fString[row] == "True") return 1;
+        if (c.fString[row] == "False") return 0;
+        return std::strtol(c.fString[row].c_str(), nullptr, 10);
+    }
+    return 0;
+  }
+
+  double DBDataset::DoubleValue(size_t row, size_t col) const {
+    const ColumnData& c = fColumns[col];
+    switch (c.fKind) {
+      case kLongColumn   :
+      case kBoolColumn   : return (double)c.Longs()[row];
+      case kDoubleColumn : return c.Doubles()[row];
+      case kStringColumn :
+      case kArrayColumn  : return std::strtod(c.fString[row].c_str(), nullptr);
+    }
+    return 0.0;
+  }
+
+  std::string DBDataset::StringValue(size_t row, size_t col) const {
+    const ColumnData& c = fColumns[col];
+    switch (c.fKind) {
+      case kLongColumn   : return std::to_string(c.Longs()[row]);
+      case kBoolColumn   : return c.Longs()[row] ? "True" : "False";
+      case kDoubleColumn : {
+        std::ostringstream s;
+        s << c.Doubles()[row];
+        return s.str();
+      }
+      case kStringColumn :
+      case kArrayColumn  : return c.fString[row];
+    }
+    return "";
+  }
+
+  DBDataset::ArrayView DBDataset::ArrayValue(size_t row, size_t col) const {
+    const ColumnData& c = fColumns[col];
+    if (c.fKind != kArrayColumn) return ArrayView();
+    const double* values = c.Arrays();
+    const size_t* offsets = c.Offsets();
+    return ArrayView(values + offsets[row], values + offsets[row+1]);
+  }
+
+  void DBDataset::Serialize(std::string& buffer) const {
+
+    buffer.append(kMagic, sizeof(kMagic));
+    Put<std::uint32_t>(buffer, kVersion);
+    Put<std::uint32_t>(buffer, kByteOrder);
+    Put<std::uint64_t>(buffer, fChannels.size());
+    Put<std::uint32_t>(buffer, fColumns.size());
+    Put<std::uint32_t>(buffer, 0);
+    Put<std::uint64_t>(buffer, fBegin.Stamp());
+    Put<std::uint64_t>(buffer, fBegin.SubStamp());
+    Put<std::uint64_t>(buffer, fEnd.Stamp());
+    Put<std::uint64_t>(buffer, fEnd.SubStamp());
+
+    for (size_t c=0; c < fColumns.size(); ++c) {
+      Put<std::uint32_t>(buffer, fColumns[c].fKind);
+      Put<std::uint32_t>(buffer, fNames[c].size());
+      Put<std::uint32_t>(buffer, fTypes[c].size());
+      buffer.append(fNames[c]);
+      buffer.append(fTypes[c]);
+    }
+    Align(buffer);
+
+    for (DBChannelID_t ch : fChannels) Put<std::uint32_t>(buffer, ch);
+    Align(buffer);
+
+    const size_t nrows = fChannels.size();
+    for (auto const& col : fColumns) {
+      switch (col.fKind) {
+        case kLongColumn   :
+        case kBoolColumn   :
+          for (size_t r=0; r < nrows; ++r) Put<std::int64_t>(buffer, col.Longs()[r]);
+          break;
+        case kDoubleColumn :
+          for (size_t r=0; r < nrows; ++r) Put<double>(buffer, col.Doubles()[r]);
+          break;
+        case kStringColumn :
+        case kArrayColumn  : {
+          std::uint64_t offset = 0;
+          Put<std::uint64_t>(buffer, offset);
+          for (auto const& v : col.fString) {
+            offset += v.size();
+            Put<std::uint64_t>(buffer, offset);
+          }
+          for (auto const& v : col.fString) buffer.append(v);
+          if (col.fKind == kStringColumn) break;
+
+          //followed by the parsed values, so that they are not parsed again on reading
+          Align(buffer);
+          const size_t* offsets = col.Offsets();
+          for (size_t r=0; r <= nrows; ++r) Put<std::uint64_t>(buffer, offsets[r]);
+          for (size_t i=0; i < offsets[nrows]; ++i) Put<double>(buffer, col.Arrays()[i]);
+          break;
+        }
+      }
+      Align(buffer);
+    }
+  }
+
+  std::shared_ptr<DBDataset> DBDataset::Deserialize(const char* buffer, size_t size) {
+    return Deserialize(buffer, size, nullptr);
+  }
+
+  std::shared_ptr<DBDataset> DBDataset::Deserialize(const char* buffer, size_t size,
+                                                    std::shared_ptr<const void> storage) {
+
+    const bool in_place = (bool)storage;
+    Reader in(buffer, size);
+    if (std::memcmp(in.Take(sizeof(kMagic)), kMagic, sizeof(kMagic)) != 0) {
+      throw WebError("DBDataset: buffer does not hold a serialized dataset!");
+    }
+    const std::uint32_t version = in.Get<std::uint32_t>();
+    if (version < 1 || version > kVersion) {
+      throw WebError("DBDataset: unsupported format version!");
+    }
+    if (in.Get<std::uint32_t>() != kByteOrder) {
+      throw WebError("DBDataset: buffer was written with a different byte order!");
+    }
+
+    std::uint64_t nrows = in.Get<std::uint64_t>();
+    std::uint32_t ncols = in.Get<std::uint32_t>();
+    in.Get<std::uint32_t>();
+    std::uint64_t stamp    = in.Get<std::uint64_t>();
+    std::uint64_t substamp = in.Get<std::uint64_t>();
+    IOVTimeStamp begin(stamp, substamp);
+    stamp    = in.Get<std::uint64_t>();
+    substamp = in.Get<std::uint64_t>();
+    IOVTimeStamp end(stamp, substamp);
+
+    std::vector<ColumnKind>  kinds;
+    std::vector<std::string> names, types;
+    for (std::uint32_t c=0; c < ncols; ++c) {
+      kinds.push_back( (ColumnKind)in.Get<std::uint32_t>() );
+      std::uint32_t name_size = in.Get<std::uint32_t>();
+      std::uint32_t type_size = in.Get<std::uint32_t>();
+      names.emplace_back(in.Take(name_size), name_size);
+      types.emplace_back(in.Take(type_size), type_size);
+    }
+    in.Align();
+
+    auto data = std::make_shared<DBDataset>(begin, end, names, types);
+
+    data->fChannels.resize(nrows);
+    for (auto& ch : data->fChannels) ch = in.Get<std::uint32_t>();
+    in.Align();
+
+    for (std::uint32_t c=0; c < ncols; ++c) {
+      ColumnData& col = data->fColumns[c];
+      col.fKind = kinds[c];
+      col.fArrayOffsets.clear();
+      switch (col.fKind) {
+        case kLongColumn   :
+        case kBoolColumn   :
+          col.fMappedLong = InPlace(in, nrows, in_place, col.fLong);
+          break;
+        case kDoubleColumn :
+          col.fMappedDouble = InPlace(in, nrows, in_place, col.fDouble);
+          break;
+        case kStringColumn :
+        case kArrayColumn  : {
+          std::vector<std::uint64_t> offsets(nrows+1);
+          for (auto& o : offsets) o = in.Get<std::uint64_t>();
+          const char* chars = in.Take(offsets.back());
+          col.fString.reserve(nrows);
+          for (std::uint64_t r=0; r < nrows; ++r) {
+            if (offsets[r+1] < offsets[r]) throw WebError("DBDataset: corrupted string column!");
+            col.fString.emplace_back(chars + offsets[r], offsets[r+1] - offsets[r]);
+          }
+          if (col.fKind == kStringColumn) break;
+
+          in.Align();
+          col.fMappedOffsets = InPlace(in, nrows+1, in_place, col.fArrayOffsets);
+          const size_t* bounds = col.Offsets();
+          for (std::uint64_t r=0; r < nrows; ++r) {
+            if (bounds[r+1] < bounds[r]) throw WebError("DBDataset: corrupted array column!");
+          }
+          if (bounds[0] != 0 || bounds[nrows] > size/sizeof(double)) {
+            throw WebError("DBDataset: corrupted array column!");
+          }
+          col.fMappedArray = InPlace(in, bounds[nrows], in_place, col.fArray);
+          break;
+        }
+        default :
+          throw WebError("DBDataset: unknown column kind!");
+      }
+      in.Align();
+    }
+    data->fStorage = std::move(storage);
+
+    return data;
+  }
+
+  void DBDataset::WriteFile(const std::string& path) const {
+
+    std::string buffer;
+    this->Serialize(buffer);
+
+    //write under a name unique to this process and thread, then move it into place
+    std::ostringstream tmp;
+    tmp << path << ".tmp." << getpid() << "." << std::hash<std::thread::id>()(std::this_thread::get_id());
+
+    FILE* out = std::fopen(tmp.str().c_str(), "wb");
+    bool ok = out && std::fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+    if (out) {
+      ok = (std::fflush(out) == 0) && ok;
+      ok = (fsync(fileno(out)) == 0) && ok;
+      ok = (std::fclose(out) == 0) && ok;
+    }
+    if (ok) ok = (std::rename(tmp.str().c_str(), path.c_str()) == 0);
+
+    if (!ok) {
+      std::string msg = "DBDataset: could not write " + path + ": " + std::strerror(errno);
+      std::remove(tmp.str().c_str());
+      throw WebError(msg);
+    }
+  }
+
+  std::shared_ptr<DBDataset> DBDataset::ReadFile(const std::string& path) {
+    auto file = std::make_shared<const MappedFile>(path);
+    if (file->Size() == 0) throw WebError("DBDataset: cannot read " + path);
+    return Deserialize(file->Data(), file->Size(), file);
+  }
+
+  std::shared_ptr<DBDataset> DBDataset::ReadCSVFile(const std::string& path,
+                                                    const std::vector<std::string>& names,
+                                                    const std::vector<std::string>& types) {
+
+    auto data = std::make_shared<DBDataset>(IOVTimeStamp::MinTimeStamp(), IOVTimeStamp::MaxTimeStamp(), names, types);
+
+    MappedFile file(path);
+    const char* pos = file.Data();
+    const char* const end = pos + file.Size();
+    data->Reserve(std::count(pos, end, '\n') + 1);
+
+    const size_t ncols = names.size();
+    std::vector<const char*> begins(ncols), ends(ncols);
+    size_t n_line = 0;
+    while (pos < end) {
+      const char* eol = (const char*)std::memchr(pos, '\n', end - pos);
+      if (!eol) eol = end;
+      const char* line = pos;
+      pos = (eol == end) ? end : eol + 1;
+      ++n_line;
+
+      //skip blank and comment lines
+      const char* first = line;
+      while (first != eol && std::isspace((unsigned char)*first)) ++first;
+      if (first == eol || *first == '#') continue;
+
+      //split into fields; extra trailing fields are ignored
+      const char* field = line;
+      for (size_t c=0; c < ncols; ++c) {
+        if (field > eol) {
+          throw WebError("DBDataset: " + path + ":" + std::to_string(n_line) + ": expected "
+                         + std::to_string(ncols) + " comma-separated columns");
+        }
+        const char* comma = (const char*)std::memchr(field, ',', eol - field);
+        if (!comma) comma = eol;
+        begins[c] = field;
+        ends[c]   = comma;
+        Trim(begins[c], ends[c]);
+        field = comma + 1;
+      }
+
+      for (size_t c=0; c < ncols; ++c) AddValue(data->fColumns[c], begins[c], ends[c]);
+      data->fChannels.push_back( (DBChannelID_t)data->fColumns[0].fLong.back() );
+    }
+
+    data->Finalize();
+    return data;
+  }
+
+  bool DBDataset::IsBinaryFile(const std::string& path) {
+    char magic[sizeof(kMagic)];
+    FILE* in = std::fopen(path.c_str(), "rb");
+    if (!in) return false;
+    bool result = std::fread(magic, 1, sizeof(magic), in) == sizeof(magic) &&
+                  std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+    std::fclose(in);
+    return result;
+  }
+
+}//end namespace lariov
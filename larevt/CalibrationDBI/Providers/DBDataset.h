@@ -0,0 +1,271 @@
+/**
+ * \file DBDataset.h
+ *
+ * \ingroup WebDBI
+ *
+ * \brief Class def header for a class DBDataset
+ */
+
+/** \addtogroup WebDBI
+
+    @{*/
+#ifndef WEBDBI_DBDATASET_H
+#define WEBDBI_DBDATASET_H
+
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Interface/CalibrationDBIFwd.h"
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace lariov {
+
+  /**
+     \class DBDataset
+     Decoded payload of a database folder for a single interval of validity.
+     Rows are kept sorted by channel and values are stored column by column,
+     so that looking up a value never touches the text returned by the server.
+  */
+  class DBDataset {
+
+    public:
+
+      enum ColumnKind {kLongColumn, kDoubleColumn, kBoolColumn, kStringColumn, kArrayColumn};
+
+      /// Read-only view of the values of an array column in one row, valid as long as the dataset
+      class ArrayView {
+
+        public:
+
+          ArrayView() : fBegin(nullptr), fEnd(nullptr) {}
+          ArrayView(const double* begin, const double* end) : fBegin(begin), fEnd(end) {}
+
+          const double* begin() const {return fBegin;}
+          const double* end() const   {return fEnd;}
+          const double* data() const  {return fBegin;}
+          size_t size() const         {return fEnd - fBegin;}
+          bool empty() const          {return fBegin == fEnd;}
+          double operator[](size_t i) const {return fBegin[i];}
+
+        private:
+
+          const double* fBegin;
+          const double* fEnd;
+      };
+
+      /**
+         A column resolved by GetColumn, read by row without looking up its name
+         or its kind again.  T is double, long, bool, std::string or ArrayView.
+         A double handle on an integer column converts each value as it is read.
+         The handle is valid as long as the dataset.
+      */
+      template <class T>
+      class ColumnHandle {
+
+        public:
+
+          using Stored_t = std::conditional_t<std::is_same<T, bool>::value, long,
+                           std::conditional_t<std::is_same<T, ArrayView>::value, double, T>>;
+          using Value_t  = std::conditional_t<std::is_same<T, std::string>::value, const std::string&, T>;
+
+          ColumnHandle() : fValues(nullptr), fOffsets(nullptr), fIntegers(nullptr) {}
+
+          Value_t operator[](size_t row) const {
+            if constexpr (std::is_same<T, double>::value) return fIntegers ? (double)fIntegers[row] : fValues[row];
+            else if constexpr (std::is_same<T, bool>::value) return fValues[row] != 0;
+            else if constexpr (std::is_same<T, ArrayView>::value) {
+              return ArrayView(fValues + fOffsets[row], fValues + fOffsets[row+1]);
+            }
+            else return fValues[row];
+          }
+
+        private:
+
+          friend class DBDataset;
+
+          ColumnHandle(const Stored_t* values, const size_t* offsets, const long* integers = nullptr)
+            : fValues(values), fOffsets(offsets), fIntegers(integers) {}
+
+          const Stored_t* fValues;
+          const size_t*   fOffsets;  //array columns only
+          const long*     fIntegers; //double handles on integer columns only
+      };
+
+      /// Constructor: the first column is always the channel number
+      DBDataset(const IOVTimeStamp& begin, const IOVTimeStamp& end,
+                const std::vector<std::string>& names,
+                const std::vector<std::string>& types);
+
+      const IOVTimeStamp& Begin() const {return fBegin;}
+      const IOVTimeStamp& End() const   {return fEnd;}
+
+      bool IsValid(const IOVTimeStamp& time) const {
+        return (time >= fBegin && time < fEnd);
+      }
+
+      size_t NRows() const    {return fChannels.size();}
+      size_t NColumns() const {return fNames.size();}
+
+      const std::vector<DBChannelID_t>& Channels() const {return fChannels;}
+      const std::vector<std::string>& ColumnNames() const {return fNames;}
+      const std::vector<std::string>& ColumnTypes() const {return fTypes;}
+      ColumnKind Kind(size_t col) const {return fColumns[col].fKind;}
+
+      /// Returns the row holding this channel, or -1 if there is none
+      int Row(DBChannelID_t channel) const;
+
+      /// Returns the index of the named column, or -1 if there is none
+      int Column(const std::string& name) const;
+
+      /// Returns the index of the named column; throws WebError if there is none
+      size_t CheckedColumn(const std::string& name) const;
+
+      /**
+         Resolve the named column for reading values of type T, e.g. once per
+         IOV before looping on the rows.  Throws WebError if there is no such
+         column or if its kind does not hold T: doubles need a floating point
+         or integer column, long and bool an integer or boolean one, ArrayView an array
+         column; std::string takes text and array columns.
+      */
+      template <class T>
+      ColumnHandle<T> GetColumn(const std::string& name) const;
+
+      /// Value accessors; numeric kinds are converted into each other
+      bool        BoolValue(size_t row, size_t col) const;
+      long        LongValue(size_t row, size_t col) const;
+      double      DoubleValue(size_t row, size_t col) const;
+      std::string StringValue(size_t row, size_t col) const;
+
+      /// Values of an array column, parsed when the row was added; empty for other kinds
+      ArrayView ArrayValue(size_t row, size_t col) const;
+
+      /**
+         Parse a bracketed, comma-separated list of numbers such as "[1.5, 2, 3e-2]"
+         and append the values to out.  Returns false if the text does not start
+         with a bracket.  Parsing stops at the closing bracket or at an empty field.
+      */
+      static bool ParseArray(const char* begin, const char* end, std::vector<double>& out);
+
+      /// Decode one row given as text fields, one per column
+      void AddRow(const char* const* fields);
+
+      /// Put rows in channel order; must be called once all rows are added
+      void Finalize();
+
+      /**
+         Compare with the payload of the previous IOV.  Fills the rows of this
+         dataset whose channel is new or has any value changed, and the channels
+         of previous that are gone.  Returns false, leaving both empty, if the
+         two cannot be compared row by row (different columns or repeated
+         channels); everything has to be read again then.
+      */
+      bool Diff(const DBDataset& previous, std::vector<size_t>& changed_rows,
+                std::vector<DBChannelID_t>& removed) const;
+
+      /// Append the compact binary form used by the on-disk cache to buffer
+      void Serialize(std::string& buffer) const;
+
+      /// Rebuild a dataset from the output of Serialize; throws WebError if the buffer is malformed
+      static std::shared_ptr<DBDataset> Deserialize(const char* buffer, size_t size);
+
+      /// Write the binary form to a file; the file is written under a temporary name and renamed into place
+      void WriteFile(const std::string& path) const;
+
+      /**
+         Read a file written by WriteFile.  The file is memory-mapped, and the mapping is kept
+         for as long as the dataset: numeric and array values are read in place, only the
+         channels and text are copied.  Jobs reading the same file share its pages.
+      */
+      static std::shared_ptr<DBDataset> ReadFile(const std::string& path);
+
+      /**
+         Read a comma-separated text file, one row per line, columns in the order
+         given by names and types.  Blank lines and lines starting with '#' are
+         skipped and fields are parsed in place from a mapping of the file.  The
+         dataset is valid at all times; throws WebError on short rows.
+      */
+      static std::shared_ptr<DBDataset> ReadCSVFile(const std::string& path,
+                                                    const std::vector<std::string>& names,
+                                                    const std::vector<std::string>& types);
+
+      /// Return true if the file starts like the output of WriteFile
+      static bool IsBinaryFile(const std::string& path);
+
+      /// Guess how a column is stored from the type reported by the database
+      static ColumnKind KindFromType(const std::string& type);
+
+    private:
+
+      struct ColumnData {
+        ColumnKind               fKind;
+        std::vector<long>        fLong;     //long and bool columns
+        std::vector<double>      fDouble;
+        std::vector<std::string> fString;   //string columns, and the text of array columns
+        std::vector<double>      fArray;    //array columns: values of row r are [fArrayOffsets[r], fArrayOffsets[r+1])
+        std::vector<size_t>      fArrayOffsets;
+
+        //values read in place from fStorage, instead of the vectors above
+        const long*   fMappedLong    = nullptr;
+        const double* fMappedDouble  = nullptr;
+        const double* fMappedArray   = nullptr;
+        const size_t* fMappedOffsets = nullptr;
+
+        const long*   Longs() const   {return fMappedLong    ? fMappedLong    : fLong.data();}
+        const double* Doubles() const {return fMappedDouble  ? fMappedDouble  : fDouble.data();}
+        const double* Arrays() const  {return fMappedArray   ? fMappedArray   : fArray.data();}
+        const size_t* Offsets() const {return fMappedOffsets ? fMappedOffsets : fArrayOffsets.data();}
+      };
+
+      /// Deserialize; with storage, the buffer is kept and values are read from it rather than copied
+      static std::shared_ptr<DBDataset> Deserialize(const char* buffer, size_t size,
+                                                    std::shared_ptr<const void> storage);
+
+      /// Decode one field, given as the text between begin and end
+      static void AddValue(ColumnData& col, const char* begin, const char* end);
+
+      /// Throw WebError unless the column is of kind a or b; what names the requested type
+      void CheckKind(size_t col, ColumnKind a, ColumnKind b, const char* what) const;
+
+      /// True if any column differs between row of this dataset and prev_row of other
+      bool RowDiffers(size_t row, const DBDataset& other, size_t prev_row) const;
+
+      void Reserve(size_t nrows);
+
+      IOVTimeStamp             fBegin;
+      IOVTimeStamp             fEnd;
+      std::vector<std::string> fNames;
+      std::vector<std::string> fTypes;
+      std::vector<DBChannelID_t> fChannels;
+      std::vector<ColumnData>  fColumns;
+      std::shared_ptr<const void> fStorage; //Mapped file the columns are read from, if any
+  };
+
+  template <class T>
+  DBDataset::ColumnHandle<T> DBDataset::GetColumn(const std::string& name) const {
+
+    const size_t col = this->CheckedColumn(name);
+    const ColumnData& c = fColumns[col];
+    if constexpr (std::is_same<T, double>::value) {
+      this->CheckKind(col, kDoubleColumn, kLongColumn, "double");
+      if (c.fKind == kLongColumn) return ColumnHandle<T>(nullptr, nullptr, c.Longs());
+      return ColumnHandle<T>(c.Doubles(), nullptr);
+    }
+    else if constexpr (std::is_same<T, long>::value || std::is_same<T, bool>::value) {
+      this->CheckKind(col, kLongColumn, kBoolColumn, std::is_same<T, long>::value ? "long" : "bool");
+      return ColumnHandle<T>(c.Longs(), nullptr);
+    }
+    else if constexpr (std::is_same<T, std::string>::value) {
+      this->CheckKind(col, kStringColumn, kArrayColumn, "string");
+      return ColumnHandle<T>(c.fString.data(), nullptr);
+    }
+    else {
+      static_assert(std::is_same<T, ArrayView>::value, "DBDataset columns hold double, long, bool, string or arrays");
+      this->CheckKind(col, kArrayColumn, kArrayColumn, "array");
+      return ColumnHandle<T>(c.Arrays(), c.Offsets());
+    }
+  }
+}
+
+#endif
+/** @} */ // end of doxygen group
@@ -0,0 +1,270 @@
+#include "DBDatasetCache.h"
+#include "WebError.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+  const char* kSuffix = ".iov";
+  const char* kOpenEnd = "max";
+  const char* kLockFile = ".fetch.lock";
+
+  bool EndsWith(const std::string& s, const std::string& end) {
+    return s.size() > end.size() && s.compare(s.size()-end.size(), end.size(), end) == 0;
+  }
+
+  /// FNV-1a hash, used to give each (url, folder, tag, channels) its own directory
+  std::uint64_t Hash(const std::string& s, std::uint64_t h = 14695981039346656037ULL) {
+    for (unsigned char c : s) {
+      h ^= c;
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+  void MakeDirectories(const std::string& path) {
+    std::string partial;
+    std::istringstream in(path);
+    std::string item;
+    if (!path.empty() && path[0] == '/') partial = "/";
+    while (std::getline(in, item, '/')) {
+      if (item.empty()) continue;
+      partial += item + "/";
+      if (mkdir(partial.c_str(), 0775) != 0 && errno != EEXIST) {
+        throw lariov::WebError("DBDatasetCache: cannot create directory " + partial + ": " + std::strerror(errno));
+      }
+    }
+  }
+
+  /// Exclusive flock on a file, held for the lifetime of the object; not taken if still held by another after wait seconds
+  class FetchLock {
+    public:
+      FetchLock(const std::string& path, unsigned long wait) :
+        fFD(open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0664)) {
+        if (fFD < 0) return;
+        //poll rather than block, so that a stuck holder only delays the other jobs for a while
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(wait);
+        while (flock(fFD, LOCK_EX | LOCK_NB) != 0) {
+          int err = errno;
+          if (err == EINTR) continue;
+          if (err == EWOULDBLOCK) {
+            if (std::chrono::steady_clock::now() < deadline) {
+              std::this_thread::sleep_for(std::chrono::milliseconds(50));
+              continue;
+            }
+            err = ETIMEDOUT;
+          }
+          close(fFD);
+          errno = err;
+          fFD = -1;
+          return;
+        }
+      }
+      ~FetchLock() { if (fFD >= 0) close(fFD); }
+      FetchLock(const FetchLock&) = delete;
+      FetchLock& operator=(const FetchLock&) = delete;
+      bool Held() const { return fFD >= 0; }
+    private:
+      int fFD;
+  };
+}
+
+namespace lariov {
+
+  DBDatasetCache::DBDatasetCache(const std::string& dir, const std::string& url,
+                                 const std::string& folder, const std::string& tag, bool lockFetches /*= false*/,
+                                 const std::string& channels /*= ""*/) :
+    fTagged(!tag.empty()), fMaxAge(24*3600), fOpenEndedMaxAge(300), fMaxSize(1ULL << 30), fLockWait(240),
+    fLockFetches(lockFetches) {
+
+    std::string key = url;
+    if (!key.empty() && key.back() == '/') key.pop_back();
+    std::uint64_t h = Hash(tag, Hash(folder + '\n', Hash(key + '\n')));
+    if (!channels.empty()) h = Hash(channels, Hash("\n", h));
+
+    std::string name;
+    for (char c : folder) name += (std::isalnum((unsigned char)c) || c == '-' || c == '_') ? c : '_';
+
+    std::ostringstream subdir;
+    subdir << dir;
+    if (!dir.empty() && dir.back() != '/') subdir << '/';
+    subdir << name << '_' << std::hex << std::setw(16) << std::setfill('0') << h;
+    fDirectory = subdir.str();
+
+    MakeDirectories(fDirectory);
+  }
+
+  std::string DBDatasetCache::SharedMemoryDirectory() {
+    return "/dev/shm/larevt_conditions_" + std::to_string(getuid());
+  }
+
+  std::string DBDatasetCache::FileName(const IOVTimeStamp& begin, const IOVTimeStamp& end) const {
+    std::string name = fDirectory + "/" + begin.DBStamp() + "_";
+    name += (end == IOVTimeStamp::MaxTimeStamp()) ? std::string(kOpenEnd) : end.DBStamp();
+    return name + kSuffix;
+  }
+
+  unsigned long DBDatasetCache::MaxAge(bool openEnded) const {
+    if (fTagged) return 0;
+    return openEnded ? fOpenEndedMaxAge : fMaxAge;
+  }
+
+  std::shared_ptr<const DBDataset> DBDatasetCache::Load(const IOVTimeStamp& ts) const {
+
+    //find the files whose name covers the requested time; the last starting one is the most
+    //specific, and of files starting at the same time the last written one is the most recent
+    std::string found;
+    IOVTimeStamp found_begin(0, 0);
+    time_t found_time = 0;
+    const time_t now = time(nullptr);
+    DIR* dir = opendir(fDirectory.c_str());
+    if (!dir) return nullptr;
+    const std::string suffix(kSuffix);
+    while (struct dirent* entry = readdir(dir)) {
+      std::string name(entry->d_name);
+      if (!EndsWith(name, suffix)) continue;
+      size_t sep = name.find('_');
+      if (sep == std::string::npos) continue;
+
+      std::string end_str = name.substr(sep+1, name.size()-suffix.size()-sep-1);
+      const bool open_ended = (end_str == kOpenEnd);
+      try {
+        IOVTimeStamp begin = IOVTimeStamp::GetFromString(name.substr(0, sep));
+        IOVTimeStamp end = open_ended ? IOVTimeStamp::MaxTimeStamp() : IOVTimeStamp::GetFromString(end_str);
+        if (ts < begin || ts >= end) continue;
+        if (!found.empty() && begin < found_begin) continue;
+
+        const std::string path = fDirectory + "/" + name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) continue;
+        const unsigned long max_age = this->MaxAge(open_ended);
+        if (max_age > 0 && now > st.st_mtime && (unsigned long)(now - st.st_mtime) > max_age) continue;
+        if (!found.empty() && begin == found_begin && st.st_mtime < found_time) continue;
+
+        found = path;
+        found_begin = begin;
+        found_time = st.st_mtime;
+      }
+      catch (std::exception const&) {
+        continue; //not one of ours
+      }
+    }
+    closedir(dir);
+    if (found.empty()) return nullptr;
+
+    try {
+      std::shared_ptr<const DBDataset> data = DBDataset::ReadFile(found);
+      if (!data->IsValid(ts)) return nullptr;
+
+      //eviction goes by access time, which mounts with relatime do not keep up to date
+      const struct timespec times[2] = {{0, UTIME_NOW}, {0, UTIME_OMIT}};
+      utimensat(AT_FDCWD, found.c_str(), times, 0);
+      return data;
+    }
+    catch (std::exception const& e) {
+      mf::LogWarning("DBDatasetCache") << "Ignoring unreadable cache file " << found << ": " << e.what();
+      return nullptr;
+    }
+  }
+
+  void DBDatasetCache::Store(const DBDataset& data) const {
+
+    std::string target = this->FileName(data.Begin(), data.End());
+    try {
+      data.WriteFile(target);
+    }
+    catch (std::exception const& e) {
+      mf::LogWarning("DBDatasetCache") << "Could not write cache file: " << e.what();
+      return;
+    }
+    this->Evict(target);
+  }
+
+  void DBDatasetCache::Evict(const std::string& keep) const {
+
+    struct File {
+      std::string        fPath;
+      unsigned long long fSize;
+      time_t             fUsed;
+    };
+    std::vector<File> files;
+    unsigned long long total = 0;
+    const time_t now = time(nullptr);
+    DIR* dir = opendir(fDirectory.c_str());
+    if (!dir) return;
+    const std::string suffix(kSuffix);
+    while (struct dirent* entry = readdir(dir)) {
+      std::string name(entry->d_name);
+      if (!EndsWith(name, suffix)) continue;
+      const std::string path = fDirectory + "/" + name;
+      struct stat st;
+      if (stat(path.c_str(), &st) != 0) continue;
+
+      const unsigned long max_age = this->MaxAge(EndsWith(name, std::string("_") + kOpenEnd + suffix));
+      if (path != keep && max_age > 0 && now > st.st_mtime && (unsigned long)(now - st.st_mtime) > max_age) {
+        unlink(path.c_str());
+        continue;
+      }
+      files.push_back({path, (unsigned long long)st.st_size, st.st_atime});
+      total += st.st_size;
+    }
+    closedir(dir);
+    if (total <= fMaxSize) return;
+
+    //least recently used first
+    std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.fUsed < b.fUsed; });
+    for (const File& file : files) {
+      if (total <= fMaxSize) break;
+      if (file.fPath == keep) continue;
+      if (unlink(file.fPath.c_str()) == 0 || errno == ENOENT) total -= file.fSize;
+    }
+  }
+
+  std::shared_ptr<const DBDataset> DBDatasetCache::Fetch(const IOVTimeStamp& ts, const Fetcher_t& fetch) const {
+
+    std::shared_ptr<const DBDataset> data = this->Load(ts);
+    if (data) return data;
+
+    if (fLockFetches) {
+      FetchLock lock(fDirectory + "/" + kLockFile, fLockWait);
+      if (lock.Held()) {
+        //another job may have stored it while we waited
+        data = this->Load(ts);
+        if (!data) {
+          data = fetch(ts);
+          this->Store(*data);
+        }
+        return data;
+      }
+      if (errno == ETIMEDOUT) {
+        mf::LogWarning("DBDatasetCache") << fDirectory << "/" << kLockFile << " still locked after " << fLockWait
+                                         << " s; fetching without it";
+      }
+      else {
+        mf::LogWarning("DBDatasetCache") << "Cannot lock " << fDirectory << "/" << kLockFile << ": "
+                                         << std::strerror(errno) << "; fetching without it";
+      }
+    }
+
+    data = fetch(ts);
+    this->Store(*data);
+    return data;
+  }
+
+}//end namespace lariov
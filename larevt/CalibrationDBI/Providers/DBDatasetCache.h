@@ -0,0 +1,112 @@
+/**
+ * \file DBDatasetCache.h
+ *
+ * \ingroup WebDBI
+ *
+ * \brief Class def header for a class DBDatasetCache
+ */
+
+/** \addtogroup WebDBI
+
+    @{*/
+#ifndef WEBDBI_DBDATASETCACHE_H
+#define WEBDBI_DBDATASETCACHE_H
+
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace lariov {
+
+  /**
+     \class DBDatasetCache
+     Local on-disk cache of decoded folder payloads.
+
+     Payloads of one folder, url and tag live in their own subdirectory of the
+     cache directory, one file per IOV named after its start and end times.
+     Files are written under a temporary name and renamed into place, so jobs
+     sharing a cache directory never see a partially written payload.
+     Without a tag, IOVs may be superseded, so their files are only used for
+     MaxAge() seconds after they were written, and open-ended ones, which the
+     next insertion closes, for OpenEndedMaxAge() seconds.  When several files
+     cover a time, the one starting last, then the one written last, is used.
+     A folder reading a subset of the channels has its own subdirectory for
+     each subset.
+
+     Each Store() removes the expired files of the directory, then the least
+     recently used ones (by access time, set at each Load()) beyond MaxSize()
+     bytes.  Readers map the files and keep the mapping, so a file may be
+     removed at any time; jobs reading the same file share its pages.
+
+     With fetch locking, e.g. for a cache in /dev/shm shared by all the jobs
+     of a node, a payload missing from the cache is retrieved by one job while
+     the others wait on a lock file and then read it back, so the server sees
+     one request instead of one per job.  The lock is released by the kernel
+     if its holder dies.  A job waits at most LockWait() seconds for it, then
+     fetches the payload itself.
+  */
+  class DBDatasetCache {
+
+    public:
+
+      using Fetcher_t = std::function<std::shared_ptr<const DBDataset>(const IOVTimeStamp&)>;
+
+      DBDatasetCache(const std::string& dir, const std::string& url,
+                     const std::string& folder, const std::string& tag, bool lockFetches = false,
+                     const std::string& channels = "");
+
+      /// Per-user directory in shared memory, for a cache shared by the jobs of a node
+      static std::string SharedMemoryDirectory();
+
+      /// Directory holding the payloads of this folder
+      const std::string& Directory() const {return fDirectory;}
+
+      /// Serve files of an untagged folder for this many seconds after they were written; one day by default
+      void SetMaxAge(unsigned long seconds) {fMaxAge = seconds;}
+      unsigned long MaxAge() const {return fMaxAge;}
+
+      /// Same for open-ended IOVs of an untagged folder; five minutes by default
+      void SetOpenEndedMaxAge(unsigned long seconds) {fOpenEndedMaxAge = seconds;}
+      unsigned long OpenEndedMaxAge() const {return fOpenEndedMaxAge;}
+
+      /// Bytes of payload files kept in the directory; 1 GiB by default
+      void SetMaxSize(unsigned long long bytes) {fMaxSize = bytes;}
+      unsigned long long MaxSize() const {return fMaxSize;}
+
+      /// Seconds to wait for the fetch lock before fetching without it; 4 minutes by default
+      void SetLockWait(unsigned long seconds) {fLockWait = seconds;}
+      unsigned long LockWait() const {return fLockWait;}
+
+      /// Return the cached dataset valid at the given time, or null if there is none
+      std::shared_ptr<const DBDataset> Load(const IOVTimeStamp& ts) const;
+
+      /// Add a dataset to the cache; failures are reported but not fatal
+      void Store(const DBDataset& data) const;
+
+      /// Return the cached dataset valid at the given time, or the one fetch() retrieves after storing it
+      std::shared_ptr<const DBDataset> Fetch(const IOVTimeStamp& ts, const Fetcher_t& fetch) const;
+
+    private:
+
+      std::string FileName(const IOVTimeStamp& begin, const IOVTimeStamp& end) const;
+
+      /// Seconds a file is served after it was written, 0 for ever
+      unsigned long MaxAge(bool openEnded) const;
+
+      /// Remove expired files, then the least recently used ones beyond the size limit, except keep
+      void Evict(const std::string& keep) const;
+
+      std::string fDirectory;
+      bool        fTagged;        //Payloads of a tag never change
+      unsigned long fMaxAge;      //Seconds, untagged folders only
+      unsigned long fOpenEndedMaxAge;
+      unsigned long long fMaxSize;
+      unsigned long fLockWait;    //Seconds
+      bool        fLockFetches;   //Retrieve missing payloads under a lock shared with the other jobs
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
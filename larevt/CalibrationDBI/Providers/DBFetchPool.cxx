@@ -0,0 +1,48 @@
+#include "DBFetchPool.h"
+
+namespace lariov {
+
+  DBFetchPool& DBFetchPool::Instance() {
+    static DBFetchPool pool(kDefaultThreads);
+    return pool;
+  }
+
+  DBFetchPool::DBFetchPool(unsigned int nthreads) :
+    fStop(false) {
+    if (nthreads == 0) nthreads = 1;
+    for (unsigned int i=0; i < nthreads; ++i) fThreads.emplace_back(&DBFetchPool::Work, this);
+  }
+
+  DBFetchPool::~DBFetchPool() {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fStop = true;
+    }
+    fWakeUp.notify_all();
+    for (auto& thread : fThreads) thread.join();
+  }
+
+  void DBFetchPool::Enqueue(std::shared_ptr<Job> job) {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fQueue.push_back(std::move(job));
+    }
+    fWakeUp.notify_one();
+  }
+
+  void DBFetchPool::Work() {
+    while (true) {
+      std::shared_ptr<Job> job;
+      {
+        std::unique_lock<std::mutex> lock(fMutex);
+        fWakeUp.wait(lock, [this]() { return fStop || !fQueue.empty(); });
+        if (fQueue.empty()) return;
+        job = std::move(fQueue.front());
+        fQueue.pop_front();
+      }
+      //jobs already run by the thread waiting for them are skipped
+      if (job->Claim()) job->fRun();
+    }
+  }
+
+}//end namespace lariov
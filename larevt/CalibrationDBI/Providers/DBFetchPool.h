@@ -0,0 +1,155 @@
+/**
+ * \file DBFetchPool.h
+ *
+ * \ingroup WebDBI
+ *
+ * \brief Class def header for a class DBFetchPool
+ */
+
+/** \addtogroup WebDBI
+
+    @{*/
+#ifndef WEBDBI_DBFETCHPOOL_H
+#define WEBDBI_DBFETCHPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lariov {
+
+  /**
+     \class DBFetchPool
+     A few threads running conditions fetches: server round trips, payload
+     decoding, folder updates at an IOV boundary.
+
+     All folders share Instance(), so the number of threads waiting on the
+     server stays bounded however many folders need data at once.  A task
+     that no thread has started yet is run by whoever waits for it, hence a
+     task may wait for another one without tying up the pool.
+  */
+  class DBFetchPool {
+
+    private:
+
+      struct Job {
+        std::function<void()> fRun;
+        std::atomic<bool>     fClaimed{false};
+
+        /// Run the job unless someone else did; returns false if it was taken already
+        bool Claim() { return !fClaimed.exchange(true, std::memory_order_acq_rel); }
+      };
+
+    public:
+
+      /// Result of a submitted task; like a std::future, but get() runs the task if it is still queued
+      template <class R>
+      class Future {
+
+        public:
+
+          Future() = default;
+          Future(Future&&) = default;
+          Future& operator=(Future&& other) {
+            this->Drop();
+            fJob = std::move(other.fJob);
+            fResult = std::move(other.fResult);
+            return *this;
+          }
+
+          /// A queued task is dropped; a running one is waited for
+          ~Future() { this->Drop(); }
+
+          bool valid() const { return fResult.valid(); }
+
+          /// True once the result is there, without waiting
+          bool ready() const {
+            return fResult.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+          }
+
+          /// Wait for the result until the given time, leaving a queued task to the pool; true if it is there
+          template <class Clock, class Duration>
+          bool wait_until(const std::chrono::time_point<Clock, Duration>& time) const {
+            return fResult.wait_until(time) == std::future_status::ready;
+          }
+
+          /// Give up on the result: a queued task is dropped, a running one finishes on its own
+          void Detach() {
+            if (!fResult.valid()) return;
+            fJob->Claim();
+            fJob.reset();
+            fResult = std::future<R>();
+          }
+
+          R get() {
+            if (fJob->Claim()) fJob->fRun();
+            fJob.reset();
+            return fResult.get();
+          }
+
+        private:
+
+          friend class DBFetchPool;
+
+          Future(std::shared_ptr<Job> job, std::future<R> result) :
+            fJob(std::move(job)), fResult(std::move(result)) {}
+
+          void Drop() {
+            if (!fResult.valid()) return;
+            if (!fJob->Claim()) fResult.wait();
+            fJob.reset();
+            fResult = std::future<R>();
+          }
+
+          std::shared_ptr<Job> fJob;
+          std::future<R>       fResult;
+      };
+
+      /// The pool shared by all folders
+      static DBFetchPool& Instance();
+
+      explicit DBFetchPool(unsigned int nthreads);
+      ~DBFetchPool();
+
+      DBFetchPool(const DBFetchPool&) = delete;
+      DBFetchPool& operator=(const DBFetchPool&) = delete;
+
+      /// Queue a task; exceptions it throws are passed on by Future::get()
+      template <class F>
+      Future<decltype(std::declval<F&>()())> Submit(F task) {
+        using R = decltype(task());
+        auto packaged = std::make_shared<std::packaged_task<R()>>(std::move(task));
+        auto job = std::make_shared<Job>();
+        job->fRun = [packaged]() { (*packaged)(); };
+        Future<R> future(job, packaged->get_future());
+        this->Enqueue(std::move(job));
+        return future;
+      }
+
+      unsigned int NThreads() const { return fThreads.size(); }
+
+      /// Threads of the shared pool
+      static constexpr unsigned int kDefaultThreads = 4;
+
+    private:
+
+      void Enqueue(std::shared_ptr<Job> job);
+      void Work();
+
+      std::mutex                       fMutex;
+      std::condition_variable          fWakeUp;
+      std::deque<std::shared_ptr<Job>> fQueue;
+      bool                             fStop;
+      std::vector<std::thread>         fThreads;  //Declared last: started once the rest is ready
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
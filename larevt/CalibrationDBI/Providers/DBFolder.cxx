@@ -1,225 +1,187 @@
 #include "DBFolder.h"
+#include "DBWebReader.h"
 #include "WebDBIConstants.h"
 #include "larevt/CalibrationDBI/IOVData/TimeStampDecoder.h"
 #include "WebError.h"
+#include "cetlib/search_path.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
 
+#include <algorithm>
+#include <chrono>
+#include <random>
 #include <sstream>
+#include <thread>
 #include <stdlib.h>
 #include <cstring>
-#include "wda.h"
+#include <unistd.h>
 
-namespace lariov {
+namespace {
+
+  /// Failures worth another try: no answer at all, an overloaded or failing server
+  bool IsTransient(int status) {
+    return status <= 0 || status == 429 || status >= 500;
+  }
 
-  typedef struct {
-      size_t ncolumns;    // Number of columns in CSV row
-      size_t nelements;   // Number of elements in data array
-      char **columns;     // Pointers to columns
-  } DataRec;
+  /// Wait before attempt n+1: delay doubled at each attempt, spread by +-50%
+  std::chrono::milliseconds Backoff(unsigned long delay_ms, unsigned int attempt) {
+    thread_local std::minstd_rand engine(std::random_device{}());
+    std::uniform_real_distribution<double> spread(0.5, 1.5);
+    return std::chrono::milliseconds((unsigned long)(delay_ms * double(1UL << std::min(attempt, 16U)) * spread(engine)));
+  }
+}
 
-  DBFolder::DBFolder(const std::string& name, const std::string& url, const std::string& tag /*= ""*/) :
-    fCachedStart(0,0), fCachedEnd(0,0) {
+namespace lariov {
 
-    fFolderName = name;
-    fURL = url;
-    fTag = tag;
-    if (fURL[fURL.length()-1] == '/') {
-      fURL = fURL.substr(0, fURL.length()-1);
+  DBFolder::DBFolder(const std::string& name, const std::string& url, const std::string& tag /*= ""*/,
+                     bool useSQLite /*= false*/) :
+    fCachedStart(0,0), fCachedEnd(0,0), fPrefetchTime(0,0) {
+
+    auto source = std::make_shared<Source>();
+    source->fFolderName = name;
+    source->fURL = url;
+    source->fTag = tag;
+    if (useSQLite) {
+      if (access(source->fURL.c_str(), R_OK) != 0) {
+        cet::search_path sp("FW_SEARCH_PATH");
+        source->fURL = sp.find_file(url);
+      }
+      source->fSQLite.reset(new DBSQLiteReader(source->fURL, name, tag));
     }
+    else if (source->fURL[source->fURL.length()-1] == '/') {
+      source->fURL = source->fURL.substr(0, source->fURL.length()-1);
+    }
+
+    source->fShared = DBFolderRegistry::Get(source->fURL, name, tag, useSQLite);
+
+    source->fMaximumTimeout = 4*60; //4 minutes
+    source->fRetries = 2;
+    source->fRetryDelay = 500;
+    source->fServerFilter = false;
+    fSource = std::move(source);
 
-    fCachedDataset = 0;
-    fNRows =0;
-    fColumns.clear();
-    fTypes.clear();
     fCachedRow = -1;
     fCachedChannel = 0;
 
-    fMaximumTimeout = 4*60; //4 minutes
+    fStaleDeadline = 0;
+    fMaxStaleAge = 600;
+    fStale = false;
+    fNStaleUpdates = 0;
+    fPrefetchWindow = 0;
+    fPrefetchAttempts = 0;
+    fPrefetchTransient = false;
+    fLockFetches = false;
   }
 
   DBFolder::~DBFolder() {
-    if (fCachedDataset) releaseDataset(fCachedDataset);
+    //a queued prefetch is dropped; a running one holds its own source and finishes unattended
+    fPrefetch.Detach();
   }
 
   int DBFolder::GetNamedChannelData(DBChannelID_t channel, const std::string& name, bool& data) {
 
-    Tuple tup;
-    size_t col = this->GetTupleColumn(channel, name, tup);
-    int err=0;
-    char buf[kBUFFER_SIZE];
-    int str_size = getStringValue(tup, col, buf, kBUFFER_SIZE, &err);
-    data = false;
-    if (std::string(buf, str_size)=="True") {
-      data = true;
-    }
-    else if (std::string(buf, str_size)=="False") {
-      data = false;
-    }
-    else std::cout<<"(DBFolder) ERROR: Can't identify data: "<<std::string(buf, str_size)<<" as boolean!"<<std::endl;
-
-    releaseTuple(tup);
-    return err;
+    size_t row;
+    size_t col = this->GetRowColumn(channel, name, row);
+    data = fCachedData->BoolValue(row, col);
+    return 0;
   }
 
   int DBFolder::GetNamedChannelData(DBChannelID_t channel, const std::string& name, long& data) {
 
-    Tuple tup;
-    size_t col = this->GetTupleColumn(channel, name, tup);
-    int err=0;
-
-    //first handle special case that the db data is boolean, but user mistakenly used long version of this function
-    char buf[kBUFFER_SIZE];
-    int str_size = getStringValue(tup, col, buf, kBUFFER_SIZE, &err);
-    if (std::string(buf, str_size)=="True") {
-      data = 1;
-    }
-    else if (std::string(buf, str_size)=="False") {
-      data = 0;
-    }
-    else { //ok, we really have a long (hopefully)
-      data = getLongValue(tup, col, &err);
-    }
-    releaseTuple(tup);
-    return err;
+    size_t row;
+    size_t col = this->GetRowColumn(channel, name, row);
+    data = fCachedData->LongValue(row, col);
+    return 0;
   }
 
   int DBFolder::GetNamedChannelData(DBChannelID_t channel, const std::string& name, double& data) {
 
-    Tuple tup;
-    size_t col = this->GetTupleColumn(channel, name, tup);
-    int err=0;
-    data = getDoubleValue(tup, col, &err);
-    releaseTuple(tup);
-    return err;
+    size_t row;
+    size_t col = this->GetRowColumn(channel, name, row);
+    data = fCachedData->DoubleValue(row, col);
+    return 0;
   }
 
   int DBFolder::GetNamedChannelData(DBChannelID_t channel, const std::string& name, std::string& data) {
 
-    Tuple tup;
-    size_t col = this->GetTupleColumn(channel, name, tup);
-    int err=0;
-    char buf[kBUFFER_SIZE];
-    int str_size = getStringValue(tup, col, buf, kBUFFER_SIZE, &err);
-    data = std::string(buf, str_size);
-    releaseTuple(tup);
-    return err;
+    size_t row;
+    size_t col = this->GetRowColumn(channel, name, row);
+    data = fCachedData->StringValue(row, col);
+    return 0;
   }
 
   int DBFolder::GetNamedChannelData(DBChannelID_t channel, const std::string& name, std::vector<double>& data) {
 
     data.clear();
 
-    Tuple tup;
-    size_t col = this->GetTupleColumn(channel, name, tup);
-    int err=0;
-    double buf[kBUFFER_SIZE];
-
-    DataRec *dataRec = (DataRec *)tup;
-    // for c2: col is an unsigned int and cannot be less than 0
-    // if (col < 0 || col >= dataRec->ncolumns) {
-    if (col >= dataRec->ncolumns) {
-      err=-1;
-      return err;
+    size_t row;
+    size_t col = this->GetRowColumn(channel, name, row);
+    switch (fCachedData->Kind(col)) {
+      case DBDataset::kArrayColumn : {
+        DBDataset::ArrayView values;
+        int err = this->GetNamedChannelData(channel, name, values);
+        data.assign(values.begin(), values.end());
+        return err;
+      }
+      case DBDataset::kStringColumn : {
+        //not declared as an array: parse the text now
+        const std::string text = fCachedData->StringValue(row, col);
+        return DBDataset::ParseArray(text.data(), text.data() + text.size(), data) ? 0 : -2;
+      }
+      default :
+        return -1;
     }
+  }
 
-    char* sptr = dataRec->columns[col];
-    if ( *sptr == '[') sptr +=1;  //expect an initial bracket and skip it
-    else {
-      err=-2;
-      return err;
-    }
+  int DBFolder::GetNamedChannelData(DBChannelID_t channel, const std::string& name, DBDataset::ArrayView& data) {
 
-    char* eptr;
-    double val;
-    unsigned int array_size=0;
-    for (unsigned int i=0; i < kBUFFER_SIZE; ++i) {
-      val = strtod(sptr, &eptr); //Try to convert
-      if (sptr==eptr) break;     //conversion failed
-      if (*sptr=='\0') break;    //end loop if buffer ends
+    data = DBDataset::ArrayView();
 
-      buf[array_size++] = val;
+    size_t row;
+    size_t col = this->GetRowColumn(channel, name, row);
+    if (fCachedData->Kind(col) != DBDataset::kArrayColumn) return -1;
 
-      if ( *eptr == ']') break;  //found the closing bracket, we're done
-      else sptr = eptr+1;        //point to the next value
+    //the values were parsed with the payload; an empty array may also be a field without brackets
+    data = fCachedData->ArrayValue(row, col);
+    if (data.empty()) {
+      const std::string text = fCachedData->StringValue(row, col);
+      size_t first = text.find_first_not_of(" \t\r\n");
+      if (first == std::string::npos || text[first] != '[') return -2;
     }
-
-    data.insert(data.begin(), buf, buf + array_size);
-    releaseTuple(tup);
-    return err;
+    return 0;
   }
 
   int DBFolder::GetChannelList( std::vector<DBChannelID_t>& channels ) const {
 
     channels.clear();
-    if (!fCachedDataset) return 1;
-
-    Tuple tup;
-    int err=0;
-    for ( int row = 0; row != fNRows; ++row) {
-      tup = getTuple(fCachedDataset, row + kNUMBER_HEADER_ROWS);
-      channels.push_back( (DBChannelID_t)getLongValue(tup,0,&err) );
-      releaseTuple(tup);
-    }
-    return err;
+    if (!fCachedData) return 1;
+
+    channels = fCachedData->Channels();
+    return 0;
   }
 
 
-  size_t DBFolder::GetTupleColumn(DBChannelID_t channel, const std::string& name, Tuple& tup ) {
+  size_t DBFolder::GetRowColumn(DBChannelID_t channel, const std::string& name, size_t& row ) {
 
-    //check if cached row is still valid
-    int err;
-    int row = -1;
-    if (fCachedRow != -1 && fCachedChannel == channel) {
-      tup = getTuple(fCachedDataset, fCachedRow + kNUMBER_HEADER_ROWS);
-      if ( channel == (DBChannelID_t)getLongValue(tup,0,&err) ) {
-	row = fCachedRow;
-      }
-      else releaseTuple(tup);
+    if (!fCachedData) {
+      throw WebError("DBFolder: no data has been retrieved from folder " + this->FolderName() + "!");
     }
 
-    //if cached row is not valid, find the new row
-    if (row == -1) {
-//std::cout<<"Channel "<<channel<<" not cached"<<std::endl;
-      //binary search for channel
-      DBChannelID_t val;
-      int l = 0, h = fNRows - 1;
-      row = (l + h )/2;
-      while ( l <= h ) {
-//std::cout<<"  "<<l<<"  "<<h<<"  "<<row<<std::endl;
-	tup = getTuple(fCachedDataset, row + kNUMBER_HEADER_ROWS);
-	val = getLongValue(tup, 0, &err);
-	releaseTuple(tup);
-
-	if (val == channel ) break;
-
-	if (val > channel) h = row - 1;
-	else            l = row + 1;
-
-	row = (l + h)/2;
-      }
-
-      //get the tuple to be returned, check that the found row matches the requested channel
-      tup = getTuple(fCachedDataset, row + kNUMBER_HEADER_ROWS);
-      if ( channel != (DBChannelID_t)getLongValue(tup, 0, &err) ) {
-        releaseTuple(tup);
+    //check if cached row is still valid, otherwise find the new row
+    if (fCachedRow == -1 || fCachedChannel != channel) {
+      int r = fCachedData->Row(channel);
+      if (r < 0) {
 	std::string msg = "Channel " + std::to_string(channel) + " is not found in database!";
 	throw WebError(msg);
       }
 
-
       //update caching info
       fCachedChannel = channel;
-      fCachedRow = row;
-
+      fCachedRow = r;
     }
+    row = fCachedRow;
 
     //get the column corresponding to input string name and return
-    for (size_t c=1; c < fColumns.size(); ++c ) {
-      if (name == fColumns[c]) return c;
-    }
-
-    std::string msg = "Column named " + name + " is not found in the database!";
-    throw WebError(msg);
-    return 0;
+    return fCachedData->CheckedColumn(name);
   }
 
   //returns true if an Update is performed, false if not
@@ -228,82 +190,269 @@ namespace lariov {
     //convert to IOVTimeStamp
     IOVTimeStamp ts = TimeStampDecoder::DecodeTimeStamp(raw_time);
 
-    //check if cache is updated
-    if (this->IsValid(ts)) return false;
+    //check if cache is updated; if we are getting close to its end, get the next one ready
+    if (this->IsValid(ts)) {
+      fStale = false;
+      this->MaybePrefetch(ts);
+      return false;
+    }
+
+    std::shared_ptr<const DBDataset> data = this->FindPreloaded(ts);
+
+    //a late payload may leave the current one in service for a while, but not for ever
+    const bool may_go_stale = fStaleDeadline > 0 && fCachedData &&
+      (!fStale || std::chrono::steady_clock::now() - fStaleSince < std::chrono::seconds(fMaxStaleAge));
+    if (!data && may_go_stale && !this->WaitForFetch(ts)) {
+      ++fNStaleUpdates;
+      if (!fStale) {
+        mf::LogWarning("DBFolder") << "Payload of folder " << this->FolderName() << " at time " << ts.DBStamp()
+                                   << " is late; serving the IOV starting at " << fCachedStart.DBStamp()
+                                   << " until it arrives";
+        fStale = true;
+        fStaleSince = std::chrono::steady_clock::now();
+      }
+      return false;
+    }
+
+    if (!data) data = this->TakePrefetched(ts);
+    if (!data) data = this->FetchDataset(ts);
+    if (fStale) {
+      mf::LogInfo("DBFolder") << "Folder " << this->FolderName() << " is current again at time " << ts.DBStamp();
+      fStale = false;
+    }
+    this->SetCachedData(std::move(data));
+
+    return true;
+  }
+
+  void DBFolder::PrefetchNext() {
+
+    if (!fCachedData || fCachedEnd == IOVTimeStamp::MaxTimeStamp()) return;
+    if (this->FindPreloaded(fCachedEnd)) return;
+
+    if (fPrefetch.valid()) {
+      //this IOV is already on its way, or a stale prefetch is still running: we cannot interrupt it
+      if (!fPrefetch.ready()) return;
+      this->HarvestPrefetch();
+    }
+    if (fPrefetched && fPrefetched->IsValid(fCachedEnd)) return;
+
+    //a failed prefetch is tried again at the next events, a few times
+    if (fPrefetchTime == fCachedEnd && fPrefetchAttempts > fSource->fRetries) return;
+
+    this->SubmitFetch(fCachedEnd);
+  }
 
-    int err=0;
+  void DBFolder::SubmitFetch(const IOVTimeStamp& ts) {
+
+    if (fPrefetchTime != ts) fPrefetchAttempts = 0;
+    ++fPrefetchAttempts;
+    fPrefetched.reset();
+    fPrefetchError = nullptr;
+    fPrefetchTime = ts;
+    std::shared_ptr<const Source> source = fSource;
+    const IOVTimeStamp time = ts;
+    fPrefetch = DBFetchPool::Instance().Submit([source, time]() { return source->Fetch(time); });
+  }
+
+  void DBFolder::HarvestPrefetch() {
+
+    try {
+      fPrefetched = fPrefetch.get();
+      fPrefetchError = nullptr;
+    }
+    catch (std::exception const& e) {
+      fPrefetched.reset();
+      fPrefetchError = std::current_exception();
+      const WebError* web = dynamic_cast<const WebError*>(&e);
+      fPrefetchTransient = web && web->Transient();
+      mf::LogWarning("DBFolder") << "Background fetch of folder " << this->FolderName() << " at time "
+                                 << fPrefetchTime.DBStamp() << " failed: " << e.what();
+    }
+  }
 
-    //release old dataset
-    if (fCachedDataset) releaseDataset(fCachedDataset);
+  std::shared_ptr<const DBDataset> DBFolder::TakePrefetched(const IOVTimeStamp& ts) {
+
+    //If the prefetch is still running and may be for this IOV, wait for it: it is the very
+    //request a synchronous fetch would issue, and it already has a head start; if it is still
+    //queued, get() runs it on this thread.  One for another IOV is left to finish in the
+    //background.  A failed prefetch is not an error, the caller falls back to a synchronous fetch.
+    if (fPrefetch.valid() && (fPrefetch.ready() || this->PrefetchMayCover(ts))) this->HarvestPrefetch();
+
+    if (!fPrefetched || !fPrefetched->IsValid(ts)) return nullptr;
+    std::shared_ptr<const DBDataset> data = std::move(fPrefetched);
+    fPrefetched.reset();
+    return data;
+  }
+
+  bool DBFolder::PrefetchMayCover(const IOVTimeStamp& ts) const {
+
+    //the IOV asked for starts at fPrefetchTime at the latest; its end is unknown until it
+    //arrives, so it is taken to be as long as the cached one
+    if (ts < fPrefetchTime) return false;
+    if (!fCachedData) return true;
+    return ts.Stamp() - fPrefetchTime.Stamp() < fCachedEnd.Stamp() - fCachedStart.Stamp();
+  }
+
+  bool DBFolder::WaitForFetch(const IOVTimeStamp& ts) {
+
+    //once stale, later updates only check whether the payload has arrived
+    const auto deadline = std::chrono::steady_clock::now()
+                          + std::chrono::milliseconds(fStale ? 0 : fStaleDeadline);
+    bool issued = false;
+    while (true) {
+      if (fPrefetch.valid()) {
+        if (!fPrefetch.wait_until(deadline)) return false;
+        this->HarvestPrefetch();
+      }
+      if (fPrefetched && fPrefetched->IsValid(ts)) return true;
+
+      //missing data or a bad payload will not get better by waiting; a fetch issued while stale
+      //was for the IOV still missing
+      if (fPrefetchError && !fPrefetchTransient && (issued || fStale || this->PrefetchMayCover(ts))) {
+        std::exception_ptr error = fPrefetchError;
+        fPrefetchError = nullptr;
+        std::rethrow_exception(error);
+      }
+
+      //the fetch for this very time failed for now: try again at the next update
+      if (issued) return false;
+
+      this->SubmitFetch(ts);
+      issued = true;
+    }
+  }
+
+  size_t DBFolder::Preload(const IOVTimeStamp& begin, const IOVTimeStamp& end) {
+
+    std::vector<std::shared_ptr<const DBDataset>> timeline;
+
+    if (fSource->fSQLite) {
+      timeline = fSource->fSQLite->FetchRange(begin, end);
+      for (auto& data : timeline) data = fSource->fShared->Adopt(std::move(data));
+    }
+    else {
+      //the server hands out one IOV per request; each one tells where the next begins
+      IOVTimeStamp time = begin;
+      while (time <= end) {
+        std::shared_ptr<const DBDataset> data = this->FetchDataset(time);
+        if (!data->IsValid(time)) break;
+        time = data->End();
+        timeline.push_back(std::move(data));
+        if (time == IOVTimeStamp::MaxTimeStamp()) break;
+      }
+    }
+
+    fTimeline = std::move(timeline);
+    mf::LogInfo("DBFolder") << "Preloaded " << fTimeline.size() << " IOVs of folder " << this->FolderName()
+                            << " between " << begin.DBStamp() << " and " << end.DBStamp();
+    return fTimeline.size();
+  }
+
+  std::shared_ptr<const DBDataset> DBFolder::FindPreloaded(const IOVTimeStamp& ts) const {
+
+    auto it = std::upper_bound(fTimeline.begin(), fTimeline.end(), ts,
+      [](const IOVTimeStamp& t, const std::shared_ptr<const DBDataset>& data) { return t < data->Begin(); });
+    if (it == fTimeline.begin()) return nullptr;
+    --it;
+    if ((*it)->IsValid(ts)) return *it;
+    return nullptr;
+  }
+
+  void DBFolder::SetCacheDirectory(const std::string& dir, bool lockFetches /*= false*/) {
+    fCacheDirectory = dir;
+    fLockFetches = lockFetches;
+    Source& source = this->ModifySource();
+    if (dir.empty()) source.fCache.reset();
+    else {
+      auto cache = std::make_shared<DBDatasetCache>(dir, source.fURL, source.fFolderName, source.fTag, lockFetches,
+                                                    source.fFilter.ToString());
+      //a job waiting on another one's fetch gives up when that fetch would have timed out
+      cache->SetLockWait(source.fMaximumTimeout);
+      source.fCache = std::move(cache);
+    }
+  }
+
+  void DBFolder::SetTimeout(int seconds) {
+    this->ModifySource().fMaximumTimeout = seconds;
+    if (fSource->fCache) this->SetCacheDirectory(fCacheDirectory, fLockFetches);
+  }
+
+  void DBFolder::SetChannelFilter(const DBChannelFilter& filter, bool serverSide /*= false*/) {
+
+    Source& source = this->ModifySource();
+    source.fFilter = filter;
+    source.fServerFilter = serverSide;
+    if (source.fSQLite) source.fSQLite->SetChannelFilter(filter);
+
+    //payloads of a subset are neither shared nor cached with those of other subsets
+    source.fShared = DBFolderRegistry::Get(source.fURL, source.fFolderName, source.fTag, this->UsesSQLite(),
+                                           filter.ToString());
+    if (source.fCache) this->SetCacheDirectory(fCacheDirectory, fLockFetches);
+  }
+
+  DBFolder::Source& DBFolder::ModifySource() {
+    auto source = std::make_shared<Source>(*fSource);
+    fSource = source;
+    return *source;
+  }
+
+  void DBFolder::SetCachedData(std::shared_ptr<const DBDataset> data) {
+
+    fCachedData = std::move(data);
+    fCachedStart = fCachedData->Begin();
+    fCachedEnd = fCachedData->End();
+    fCachedRow = -1;
+    fCachedChannel = 0;
+  }
+
+  std::shared_ptr<const DBDataset> DBFolder::FetchDataset(const IOVTimeStamp& ts) const {
+    return fSource->Fetch(ts);
+  }
+
+  std::shared_ptr<const DBDataset> DBFolder::Source::Fetch(const IOVTimeStamp& ts) const {
+    return fShared->Fetch(ts, [this](const IOVTimeStamp& time) { return this->Retrieve(time); });
+  }
+
+  std::shared_ptr<const DBDataset> DBFolder::Source::Retrieve(const IOVTimeStamp& ts) const {
+
+    //a payload in the local cache saves the round trip to the server
+    if (fCache) return fCache->Fetch(ts, [this](const IOVTimeStamp& time) { return this->Download(time); });
+    return this->Download(ts);
+  }
+
+  std::shared_ptr<const DBDataset> DBFolder::Source::Download(const IOVTimeStamp& ts) const {
+
+    if (fSQLite) return fSQLite->Fetch(ts);
 
     //get full url string
     std::stringstream fullurl;
     fullurl << fURL << "/data?f=" << fFolderName
             << "&t=" << ts.DBStamp();
     if (fTag.length() > 0) fullurl << "&tag=" << fTag;
+    if (fServerFilter && !fFilter.Empty()) fullurl << "&c=" << fFilter.ToString();
 
-    //get new dataset
-    int status = -1;
-    fCachedDataset = getDataWithTimeout(fullurl.str().c_str(), NULL, fMaximumTimeout, &err);
-    status = getHTTPstatus(fCachedDataset);
+    //get new dataset, decoded as it arrives; a busy or unreachable server gets a few more chances
+    std::shared_ptr<DBDataset> data;
+    for (unsigned int attempt = 0; ; ++attempt) {
+      std::string message;
+      int status = DBWebReader::Fetch(fullurl.str(), fMaximumTimeout, data, message, fFilter);
+      if (status == 200) break;
 
-    //Can add some more queries here if we get http error 504
-    /*if (status == 504) {
-      //try again
-    }*/
+      std::string msg = "HTTP error from " + fullurl.str()+": status: " + std::to_string(status) + ": " + message;
+      if (attempt >= fRetries || !IsTransient(status)) throw WebError(msg, IsTransient(status));
 
-    if (status != 200) {
-      std::string msg = "HTTP error from " + fullurl.str()+": status: " + std::to_string(status) + ": " + std::string(getHTTPmessage(fCachedDataset));
-      throw WebError(msg);
+      std::chrono::milliseconds wait = Backoff(fRetryDelay, attempt);
+      mf::LogWarning("DBFolder") << msg << "; retrying in " << wait.count() << " ms";
+      std::this_thread::sleep_for(wait);
     }
 
-    //update info about cached data
-    fNRows = getNtuples(fCachedDataset) - kNUMBER_HEADER_ROWS;
-    //std::cout<<"Retrieved "<<fNRows<<" rows from "<<fullurl.str()<<std::endl;
-    if (fNRows < 1) {
+    if (!data) {
       std::stringstream msg;
       msg << "Time " << ts.DBStamp() << ": Data not found in database.";
       throw WebError(msg.str());
-      fCachedStart = fCachedEnd = ts;
     }
-
-    //start and end times
-    Tuple tup;
-    tup = getTuple(fCachedDataset, 0);
-    char buf[kBUFFER_SIZE];
-    getStringValue(tup,0, buf, kBUFFER_SIZE, &err);
-    fCachedStart = IOVTimeStamp::GetFromString(std::string(buf));
-    releaseTuple(tup);
-
-    tup = getTuple(fCachedDataset, 1);
-    getStringValue(tup,0, buf, kBUFFER_SIZE, &err);
-    if ( 0 == strcmp(buf,"-") ) {
-      fCachedEnd = IOVTimeStamp::MaxTimeStamp();
-    }
-    else {
-      fCachedEnd = IOVTimeStamp::GetFromString(std::string(buf));
-    }
-    releaseTuple(tup);
-
-    //column names
-    tup = getTuple(fCachedDataset, 2);
-    fColumns.clear();
-    for (int c=0; c < getNfields(tup); ++c) {
-      getStringValue(tup, c, buf, kBUFFER_SIZE, &err);
-      fColumns.push_back(buf);
-    }
-    releaseTuple(tup);
-
-    //column types
-    tup = getTuple(fCachedDataset, 3);
-    fTypes.clear();
-    for (int c=0; c < getNfields(tup); ++c) {
-      getStringValue(tup, c, buf, kBUFFER_SIZE, &err);
-      fTypes.push_back(buf);
-    }
-    releaseTuple(tup);
-
-    return true;
+    return data;
   }
 
 }//end namespace lariov
@@ -3,18 +3,25 @@
 
 #include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
 #include "larevt/CalibrationDBI/Interface/CalibrationDBIFwd.h"
+#include "larevt/CalibrationDBI/Providers/DBChannelFilter.h"
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+#include "larevt/CalibrationDBI/Providers/DBDatasetCache.h"
+#include "larevt/CalibrationDBI/Providers/DBFetchPool.h"
+#include "larevt/CalibrationDBI/Providers/DBFolderRegistry.h"
+#include "larevt/CalibrationDBI/Providers/DBSQLiteFile.h"
+#include <chrono>
+#include <exception>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace lariov {
 
-  typedef void *Dataset;
-  typedef void *Tuple;
-
   class DBFolder {
 
     public:
-      DBFolder(const std::string& name, const std::string& url, const std::string& tag = "");
+      /// With useSQLite set, url names a local SQLite file (looked up in FW_SEARCH_PATH) instead of a web server
+      DBFolder(const std::string& name, const std::string& url, const std::string& tag = "", bool useSQLite = false);
       virtual ~DBFolder();
 
       int GetNamedChannelData(DBChannelID_t channel, const std::string& name, bool& data);
@@ -23,9 +30,16 @@ namespace lariov {
       int GetNamedChannelData(DBChannelID_t channel, const std::string& name, std::string& data);
       int GetNamedChannelData(DBChannelID_t channel, const std::string& name, std::vector<double>& data);
 
-      const std::string& URL() const {return fURL;}
-      const std::string& FolderName() const {return fFolderName;}
-      const std::string& Tag() const {return fTag;}
+      /// Values of an array column without copying them; the view is valid until the next update of the folder
+      int GetNamedChannelData(DBChannelID_t channel, const std::string& name, DBDataset::ArrayView& data);
+
+      const std::string& URL() const {return fSource->fURL;}
+      const std::string& FolderName() const {return fSource->fFolderName;}
+      const std::string& Tag() const {return fSource->fTag;}
+      bool UsesSQLite() const {return (bool)fSource->fSQLite;}
+
+      /// Decoded payload of the cached IOV, null before the first update
+      std::shared_ptr<const DBDataset> CachedData() const {return fCachedData;}
 
       const IOVTimeStamp& CachedStart() const {return fCachedStart;}
       const IOVTimeStamp& CachedEnd() const   {return fCachedEnd;}
@@ -34,28 +48,178 @@ namespace lariov {
 
       int GetChannelList( std::vector<DBChannelID_t>& channels ) const;
 
+      /**
+        Start fetching the IOV following the cached one in the background, on the shared DBFetchPool.
+        A failed prefetch is issued again at the next calls, up to the number of retries of SetRetries().
+      */
+      void PrefetchNext();
+
+      /// Prefetch the next IOV once events are closer than this (in seconds) to the end of the cached one; 0 disables
+      void SetPrefetchWindow(unsigned long seconds) {fPrefetchWindow = seconds;}
+      unsigned long PrefetchWindow() const {return fPrefetchWindow;}
+
+      /// Call PrefetchNext() if ts, covered by the cached IOV, is within the prefetch window of its end; cheap otherwise
+      void MaybePrefetch(const IOVTimeStamp& ts) {
+        if (fPrefetchWindow > 0 && fCachedData && fCachedEnd != IOVTimeStamp::MaxTimeStamp() &&
+            ts.Stamp() + fPrefetchWindow >= fCachedEnd.Stamp()) {
+          this->PrefetchNext();
+        }
+      }
+
+      /// Give up on a request to the web server after this many seconds; 4 minutes by default
+      void SetTimeout(int seconds);
+
+      /// Repeat requests failing for lack of an answer or with a server error (5xx, 429) up to n times, after
+      /// waiting about delay_ms, doubled at each attempt and randomly spread by 50% so that jobs do not retry in step
+      void SetRetries(unsigned int n, unsigned long delay_ms) {
+        Source& source = this->ModifySource();
+        source.fRetries = n;
+        source.fRetryDelay = delay_ms;
+      }
+
+      /**
+        If the payload of a new IOV is not there within deadline_ms, keep serving the current one and let
+        the fetch finish in the background; later updates take it as soon as it is there.  Updates return
+        false meanwhile, without waiting again.  Only a late payload or a transient failure (no answer,
+        429, 5xx) is waited out this way: other failures, such as missing data or a payload that cannot be
+        decoded, are thrown at once.  0, the default, always waits for the payload; there is nothing to
+        serve before the first update anyway.
+      */
+      void SetStaleDeadline(unsigned long deadline_ms) {fStaleDeadline = deadline_ms;}
+
+      /// Stop serving stale data after this many seconds: updates wait for the payload again, and throw if it fails
+      void SetMaxStaleAge(unsigned long seconds) {fMaxStaleAge = seconds;}
+
+      /// True while the served data are kept past their IOV because the next payload is late
+      bool IsStale() const {return fStale;}
+
+      /// Number of updates that kept serving data past their IOV
+      size_t NStaleUpdates() const {return fNStaleUpdates;}
+
+      /**
+        Look for payloads in this local directory before querying the server, and store fetched ones there.
+        With lockFetches, jobs sharing the directory take turns to fetch a missing payload, and the others read it back.
+      */
+      void SetCacheDirectory(const std::string& dir, bool lockFetches = false);
+
+      /**
+        Only read the rows of the channels of filter, e.g. those of one APA.  SQLite files are queried
+        for them alone, and so is the web server with serverSide, through the query parameter c
+        ("&c=0-2559,4800"); rows of other channels it sends anyway are dropped as the payload is decoded,
+        before they are split into fields.  An IOV without any row of these channels is served with
+        no row rather than as missing data.  Call before the first update.
+      */
+      void SetChannelFilter(const DBChannelFilter& filter, bool serverSide = false);
+      const DBChannelFilter& ChannelFilter() const {return fSource->fFilter;}
+
+      /**
+        Retrieve and decode the dataset valid at the given time, without touching the cached one; safe to call from any thread.
+        Folders with the same url, name and tag share their payloads: one already held by any of them is not fetched again.
+      */
+      std::shared_ptr<const DBDataset> FetchDataset(const IOVTimeStamp& ts) const;
+
+      /**
+        Fetch every IOV overlapping [begin, end] now, e.g. the time span of a run.
+        Later updates to a time inside the range take the payload from memory.
+        Replaces any earlier preload; returns the number of IOVs held.  Not to be
+        called while another thread updates this folder.
+      */
+      size_t Preload(const IOVTimeStamp& begin, const IOVTimeStamp& end);
+
+      /// Number of preloaded IOVs
+      size_t NPreloaded() const {return fTimeline.size();}
+
     private:
-      size_t GetTupleColumn( DBChannelID_t channel, const std::string& name, Tuple& tup );
+
+      /**
+        Where and how payloads are fetched.  Background fetches hold it rather than the folder, so
+        that a folder going away does not have to wait for them; setters replace it with a modified copy.
+      */
+      struct Source {
+        std::string   fURL;
+        std::string   fFolderName;
+        std::string   fTag;
+        int           fMaximumTimeout;
+        unsigned int  fRetries;
+        unsigned long fRetryDelay;     //milliseconds
+
+        DBChannelFilter fFilter;        //Channels read, all of them if empty
+        bool            fServerFilter;  //Ask the web server for the channels of fFilter only
+
+        std::shared_ptr<DBDatasetCache> fCache;  //Optional on-disk cache, null if unused
+        std::shared_ptr<DBSQLiteReader> fSQLite; //Local SQLite backend, null when reading from the web server
+        std::shared_ptr<DBSharedFolder> fShared; //Payloads shared with the other folders reading the same data
+
+        /// See DBFolder::FetchDataset
+        std::shared_ptr<const DBDataset> Fetch(const IOVTimeStamp& ts) const;
+
+        /// Retrieve the dataset from the local cache or the backend, bypassing the shared folder
+        std::shared_ptr<const DBDataset> Retrieve(const IOVTimeStamp& ts) const;
+
+        /// Retrieve the dataset from the SQLite file or the web server
+        std::shared_ptr<const DBDataset> Download(const IOVTimeStamp& ts) const;
+      };
+
+      /// Copy of the source for a setter to modify; fetches already under way keep the old one
+      Source& ModifySource();
+
+      /// Fetch the dataset valid at ts on the shared DBFetchPool
+      void SubmitFetch(const IOVTimeStamp& ts);
+
+      /// Return the row of the cached dataset and the index of the named column
+      size_t GetRowColumn( DBChannelID_t channel, const std::string& name, size_t& row );
 
       bool IsValid(const IOVTimeStamp& time) const {
         if (time >= fCachedStart && time < fCachedEnd) return true;
 	else return false;
       }
 
+      /// Return the prefetched dataset if it covers the given time
+      std::shared_ptr<const DBDataset> TakePrefetched(const IOVTimeStamp& ts);
+
+      /// False if the running background fetch cannot be for the IOV of ts: before the time it was issued for, or well past it
+      bool PrefetchMayCover(const IOVTimeStamp& ts) const;
+
+      /// Collect the result of the background fetch, which must be done or about to be; failures are logged and kept
+      void HarvestPrefetch();
+
+      /**
+        Have a background fetch covering ts under way and wait for it until the stale deadline; true if it is there.
+        A failure of that fetch which is not transient is thrown.
+      */
+      bool WaitForFetch(const IOVTimeStamp& ts);
 
-      std::string fURL;
-      std::string fFolderName;
-      std::string fTag;
-      int         fMaximumTimeout;
+      /// Return the preloaded dataset covering the given time, if any
+      std::shared_ptr<const DBDataset> FindPreloaded(const IOVTimeStamp& ts) const;
 
-      Dataset                  fCachedDataset;
-      int                      fNRows;         //Number of channels in cached dataset
+      void SetCachedData(std::shared_ptr<const DBDataset> data);
+
+
+      std::shared_ptr<const Source> fSource;
+      unsigned long fStaleDeadline;  //milliseconds, 0 to always wait
+      unsigned long fMaxStaleAge;    //seconds
+      bool          fStale;
+      std::chrono::steady_clock::time_point fStaleSince;
+      size_t        fNStaleUpdates;
+
+      std::shared_ptr<const DBDataset> fCachedData;
       IOVTimeStamp               fCachedStart;
       IOVTimeStamp               fCachedEnd;
-      std::vector<std::string> fColumns;       //Column names
-      std::vector<std::string> fTypes;         //Column types
       int                      fCachedRow;     //Cache most recently retrieved row and channel numbers
       DBChannelID_t            fCachedChannel;
+
+      std::string     fCacheDirectory;
+      bool            fLockFetches;
+
+      std::vector<std::shared_ptr<const DBDataset>> fTimeline; //Preloaded IOVs, ordered by start time
+
+      unsigned long            fPrefetchWindow;
+      IOVTimeStamp             fPrefetchTime;  //Time the background fetch was issued for
+      unsigned int             fPrefetchAttempts; //Background fetches issued for fPrefetchTime
+      std::shared_ptr<const DBDataset> fPrefetched; //Result of the background fetch, once collected
+      std::exception_ptr       fPrefetchError; //Failure of the background fetch, once collected
+      bool                     fPrefetchTransient; //The failure may go away if the fetch is repeated
+      DBFetchPool::Future<std::shared_ptr<const DBDataset>> fPrefetch;
   };
 }
 
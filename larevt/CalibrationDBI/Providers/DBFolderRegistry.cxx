@@ -0,0 +1,110 @@
+#include "DBFolderRegistry.h"
+
+namespace lariov {
+
+  //=============================================
+  // DBSharedFolder
+  //=============================================
+  std::shared_ptr<const DBDataset> DBSharedFolder::FindLive(const IOVTimeStamp& ts) {
+
+    std::shared_ptr<const DBDataset> found;
+    for (auto it = fPayloads.begin(); it != fPayloads.end(); ) {
+      std::shared_ptr<const DBDataset> data = it->lock();
+      if (!data) {
+        it = fPayloads.erase(it);
+        continue;
+      }
+      if (!found && data->IsValid(ts)) found = std::move(data);
+      ++it;
+    }
+    return found;
+  }
+
+  std::shared_ptr<const DBDataset> DBSharedFolder::Fetch(const IOVTimeStamp& ts, const Fetcher_t& fetch) {
+
+    const Time_t key(ts.Stamp(), ts.SubStamp());
+    std::promise<std::shared_ptr<const DBDataset>> promise;
+    {
+      std::unique_lock<std::mutex> lock(fMutex);
+      if (std::shared_ptr<const DBDataset> data = this->FindLive(ts)) return data;
+
+      //somebody is already retrieving this time: wait for the result
+      auto pending = fPending.find(key);
+      if (pending != fPending.end()) {
+        std::shared_future<std::shared_ptr<const DBDataset>> result = pending->second;
+        lock.unlock();
+        return result.get();
+      }
+      fPending.emplace(key, promise.get_future().share());
+      ++fNFetches;
+    }
+
+    //retrieve outside the lock: other times and folders are not held up
+    std::shared_ptr<const DBDataset> data;
+    try {
+      data = fetch(ts);
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fPending.erase(key);
+      promise.set_exception(std::current_exception());
+      throw;
+    }
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    fPayloads.push_back(data);
+    fPending.erase(key);
+    promise.set_value(data);
+    return data;
+  }
+
+  std::shared_ptr<const DBDataset> DBSharedFolder::Adopt(std::shared_ptr<const DBDataset> data) {
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    std::shared_ptr<const DBDataset> live = this->FindLive(data->Begin());
+    if (live && live->Begin() == data->Begin() && live->End() == data->End()) return live;
+    fPayloads.push_back(data);
+    return data;
+  }
+
+  size_t DBSharedFolder::NFetches() const {
+    std::lock_guard<std::mutex> lock(fMutex);
+    return fNFetches;
+  }
+
+  //=============================================
+  // DBFolderRegistry
+  //=============================================
+  std::mutex DBFolderRegistry::fMutex;
+  std::map<std::string, std::weak_ptr<DBSharedFolder>> DBFolderRegistry::fFolders;
+
+  std::shared_ptr<DBSharedFolder> DBFolderRegistry::Get(const std::string& url, const std::string& folder,
+                                                       const std::string& tag, bool useSQLite,
+                                                       const std::string& channels /*= ""*/) {
+
+    const std::string key = (useSQLite ? "sqlite:" : "web:") + url + '\n' + folder + '\n' + tag + '\n' + channels;
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    std::weak_ptr<DBSharedFolder>& entry = fFolders[key];
+    std::shared_ptr<DBSharedFolder> shared = entry.lock();
+    if (!shared) {
+      shared = std::make_shared<DBSharedFolder>();
+      entry = shared;
+    }
+
+    //forget the folders nobody uses any more
+    for (auto it = fFolders.begin(); it != fFolders.end(); ) {
+      if (it->second.expired()) it = fFolders.erase(it);
+      else ++it;
+    }
+    return shared;
+  }
+
+  size_t DBFolderRegistry::NFolders() {
+    std::lock_guard<std::mutex> lock(fMutex);
+    size_t n = 0;
+    for (auto const& entry : fFolders) if (!entry.second.expired()) ++n;
+    return n;
+  }
+
+}//end namespace lariov
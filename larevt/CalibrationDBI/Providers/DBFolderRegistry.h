@@ -0,0 +1,96 @@
+/**
+ * \file DBFolderRegistry.h
+ *
+ * \ingroup WebDBI
+ *
+ * \brief Class def header for classes DBSharedFolder and DBFolderRegistry
+ */
+
+/** \addtogroup WebDBI
+
+    @{*/
+#ifndef WEBDBI_DBFOLDERREGISTRY_H
+#define WEBDBI_DBFOLDERREGISTRY_H
+
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lariov {
+
+  /**
+     \class DBSharedFolder
+     The payloads of one folder (url, name, tag), shared by every DBFolder
+     reading it in the process.
+
+     A payload still held by any DBFolder is handed to the others without a
+     new fetch, and simultaneous requests for the same time, e.g. from two
+     algorithms at the same event, are merged into one.  Payloads are owned
+     by the folders using them and go away with the last of them.
+  */
+  class DBSharedFolder {
+
+    public:
+
+      using Fetcher_t = std::function<std::shared_ptr<const DBDataset>(const IOVTimeStamp&)>;
+
+      DBSharedFolder() : fNFetches(0) {}
+
+      DBSharedFolder(const DBSharedFolder&) = delete;
+      DBSharedFolder& operator=(const DBSharedFolder&) = delete;
+
+      /// Return a live payload valid at the given time, or the one fetch() retrieves
+      std::shared_ptr<const DBDataset> Fetch(const IOVTimeStamp& ts, const Fetcher_t& fetch);
+
+      /// Return the live payload of the same IOV if there is one, else keep track of this one
+      std::shared_ptr<const DBDataset> Adopt(std::shared_ptr<const DBDataset> data);
+
+      /// Number of payloads actually retrieved so far
+      size_t NFetches() const;
+
+    private:
+
+      std::shared_ptr<const DBDataset> FindLive(const IOVTimeStamp& ts);
+
+      using Time_t = std::pair<unsigned long, unsigned long>;
+
+      mutable std::mutex                            fMutex;
+      std::vector<std::weak_ptr<const DBDataset>>   fPayloads;  //Payloads fetched so far; expired ones are pruned
+      std::map<Time_t, std::shared_future<std::shared_ptr<const DBDataset>>> fPending; //Fetches in flight, by time
+      size_t                                        fNFetches;
+  };
+
+  /**
+     \class DBFolderRegistry
+     Hands out the DBSharedFolder of a folder; it lives as long as a DBFolder
+     holds it.  Folders reading a subset of the channels, given as by
+     DBChannelFilter::ToString(), share their payloads only with folders
+     reading the same subset.
+  */
+  class DBFolderRegistry {
+
+    public:
+
+      static std::shared_ptr<DBSharedFolder> Get(const std::string& url, const std::string& folder,
+                                                 const std::string& tag, bool useSQLite,
+                                                 const std::string& channels = "");
+
+      /// Number of shared folders in use
+      static size_t NFolders();
+
+    private:
+
+      static std::mutex fMutex;
+      static std::map<std::string, std::weak_ptr<DBSharedFolder>> fFolders;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
@@ -0,0 +1,139 @@
+/**
+ * \file DBRowSchema.h
+ *
+ * \ingroup WebDBI
+ *
+ * \brief Compile-time binding of database columns to calibration row types
+ */
+
+/** \addtogroup WebDBI
+
+    @{*/
+#ifndef WEBDBI_DBROWSCHEMA_H
+#define WEBDBI_DBROWSCHEMA_H
+
+#include "larevt/CalibrationDBI/IOVData/Snapshot.h"
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lariov {
+
+  /// One database column of a row type: its name, the type it is read as, and how it is set in a row
+  template <class Value, class Setter>
+  struct DBColumn {
+    using Value_t = Value;
+
+    const char* fName;
+    Setter      fSet;     //Member function of the row, or callable taking the row and the value
+  };
+
+  template <class Value, class Setter>
+  constexpr DBColumn<Value, Setter> MakeDBColumn(const char* name, Setter set) {
+    return DBColumn<Value, Setter>{name, set};
+  }
+
+  /**
+     \class DBRowSchema
+     Database columns of a calibration row type T, to be specialized for each
+     type read with ReadRows.  A specialization has a static Columns() giving a
+     tuple of MakeDBColumn, e.g.
+
+         template <> struct DBRowSchema<PmtGain> {
+           static constexpr auto Columns() {
+             return std::make_tuple(MakeDBColumn<double>("gain", &PmtGain::SetGain), ...);
+           }
+         };
+
+     The channel column is implicit; T is constructed from the channel number.
+  */
+  template <class T>
+  struct DBRowSchema;
+
+  namespace details {
+
+    template <class T, class Column, class Handle>
+    void FillColumn(std::vector<T>& decoded, const std::vector<size_t>* rows, const Column& column,
+                    const Handle& values) {
+      const size_t n = decoded.size();
+      if (rows) {
+        for (size_t i = 0; i != n; ++i) std::invoke(column.fSet, decoded[i], values[(*rows)[i]]);
+      }
+      else {
+        for (size_t i = 0; i != n; ++i) std::invoke(column.fSet, decoded[i], values[i]);
+      }
+    }
+
+    template <class T, class Columns, size_t... I>
+    void FillColumns(const DBDataset& data, std::vector<T>& decoded, const std::vector<size_t>* rows,
+                     const Columns& columns, std::index_sequence<I...>) {
+
+      //resolve every column before filling any: a schema mismatch throws here
+      auto handles = std::make_tuple(
+        data.GetColumn<typename std::tuple_element_t<I, Columns>::Value_t>(std::get<I>(columns).fName)...);
+
+      //then one pass per column
+      (FillColumn(decoded, rows, std::get<I>(columns), std::get<I>(handles)), ...);
+    }
+
+    template <class T, class Columns, size_t... I>
+    std::function<T(size_t)> RowMaker(std::shared_ptr<const DBDataset> data, const Columns& columns,
+                                      std::index_sequence<I...>) {
+
+      auto handles = std::make_tuple(
+        data->GetColumn<typename std::tuple_element_t<I, Columns>::Value_t>(std::get<I>(columns).fName)...);
+
+      //the handles point into the dataset, which the maker keeps alive
+      return [data, columns, handles](size_t row) {
+        T decoded(data->Channels()[row]);
+        (std::invoke(std::get<I>(columns).fSet, decoded, std::get<I>(handles)[row]), ...);
+        return decoded;
+      };
+    }
+  }
+
+  /**
+     Fill the snapshot with rows of T decoded from the dataset, as described by
+     DBRowSchema<T>; only the given rows of the dataset if any.  Throws WebError
+     if a column is missing or of the wrong type.
+  */
+  template <class T>
+  void ReadRows(const DBDataset& data, Snapshot<T>& snapshot, const std::vector<size_t>* rows = nullptr) {
+
+    const auto columns = DBRowSchema<T>::Columns();
+
+    const size_t n = rows ? rows->size() : data.NRows();
+    std::vector<T> decoded;
+    decoded.reserve(n);
+    for (size_t i = 0; i != n; ++i) decoded.emplace_back(data.Channels()[rows ? (*rows)[i] : i]);
+
+    details::FillColumns(data, decoded, rows, columns,
+                         std::make_index_sequence<std::tuple_size<std::decay_t<decltype(columns)>>::value>());
+    snapshot.AddOrReplaceRows(std::move(decoded));
+  }
+
+  /**
+     Make the snapshot a lazy one over all the rows of the dataset, see
+     Snapshot::SetLazyRows: a row of T is only decoded, as described by
+     DBRowSchema<T>, when its channel is first accessed.  The snapshot
+     shares the channel list of the dataset.  The columns are checked here,
+     and throw WebError if missing or of the wrong type.
+  */
+  template <class T>
+  void ReadRowsLazily(std::shared_ptr<const DBDataset> data, Snapshot<T>& snapshot) {
+
+    static_assert(std::is_same<DBChannelID_t, unsigned int>::value, "snapshot channels are the dataset ones");
+    const auto columns = DBRowSchema<T>::Columns();
+    std::shared_ptr<const std::vector<unsigned int>> channels(data, &data->Channels());
+    snapshot.SetLazyRows(std::move(channels),
+                         details::RowMaker<T>(std::move(data), columns,
+                                              std::make_index_sequence<std::tuple_size<std::decay_t<decltype(columns)>>::value>()));
+  }
+}
+
+#endif
+/** @} */ // end of doxygen group
@@ -0,0 +1,370 @@
+#include "DBSQLiteFile.h"
+#include "WebError.h"
+
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <sqlite3.h>
+#include <vector>
+
+namespace {
+
+  const long long kSubStampsPerStamp = 1000000;
+
+  /// Owns a prepared statement
+  class Statement {
+
+    public:
+
+      Statement(sqlite3* db, const std::string& sql) : fStmt(nullptr) {
+        if (sqlite3_prepare_v2(db, sql.c_str(), -1, &fStmt, nullptr) != SQLITE_OK) {
+          std::string msg = "SQLite error preparing \"" + sql + "\": " + sqlite3_errmsg(db);
+          sqlite3_finalize(fStmt);
+          throw lariov::WebError(msg);
+        }
+      }
+
+      ~Statement() { sqlite3_finalize(fStmt); }
+
+      sqlite3_stmt* get() const { return fStmt; }
+
+    private:
+
+      sqlite3_stmt* fStmt;
+  };
+
+  void Execute(sqlite3* db, const std::string& sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+      std::string msg = "SQLite error executing \"" + sql + "\": " + (err ? err : "");
+      sqlite3_free(err);
+      throw lariov::WebError(msg);
+    }
+  }
+
+  std::string Quote(const std::string& name) {
+    std::string quoted = "\"";
+    for (char c : name) {
+      if (c == '"') quoted += '"';
+      quoted += c;
+    }
+    return quoted + "\"";
+  }
+
+  /// SQLite type names cannot hold brackets, so array types are spelled out
+  std::string SQLType(const std::string& type) {
+    std::string sqltype;
+    for (size_t i=0; i < type.size(); ++i) {
+      if (type.compare(i, 2, "[]") == 0) {
+        sqltype += " array";
+        ++i;
+      }
+      else if (std::isalnum((unsigned char)type[i]) || type[i] == ' ') sqltype += type[i];
+    }
+    return sqltype.empty() ? "text" : sqltype;
+  }
+
+  bool HasColumn(sqlite3* db, const std::string& table, const std::string& column) {
+    Statement stmt(db, "PRAGMA table_info(" + Quote(table) + ")");
+    while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+      const unsigned char* name = sqlite3_column_text(stmt.get(), 1);
+      if (name && column == (const char*)name) return true;
+    }
+    return false;
+  }
+
+  /// Selects the IOVs visible with the given tag, or all active ones if untagged
+  std::string IOVSelection(const std::string& folder, const std::string& tag, bool hasEndTime) {
+    const std::string end_time = hasEndTime ? "i.end_time" : "NULL";
+    if (tag.empty()) {
+      return "SELECT i.iov_id AS iov_id, i.begin_time AS begin_time, " + end_time + " AS end_time FROM "
+        + Quote(folder + "_iovs") + " i WHERE i.active != 0";
+    }
+    return "SELECT i.iov_id AS iov_id, i.begin_time AS begin_time, " + end_time + " AS end_time FROM "
+      + Quote(folder + "_iovs") + " i JOIN " + Quote(folder + "_tag_iovs") + " t ON t.iov_id = i.iov_id WHERE t.tag = ?2";
+  }
+
+  /// The earlier of the recorded end of an IOV, if any, and the start of the next one
+  lariov::IOVTimeStamp IOVEnd(sqlite3_stmt* stmt, int end_col, const lariov::IOVTimeStamp& next) {
+    if (sqlite3_column_type(stmt, end_col) == SQLITE_NULL) return next;
+    const lariov::IOVTimeStamp end = lariov::DBSQLite::DecodeTime(sqlite3_column_int64(stmt, end_col));
+    return (end < next) ? end : next;
+  }
+}
+
+namespace lariov {
+
+  long long DBSQLite::EncodeTime(const IOVTimeStamp& ts) {
+    return (long long)ts.Stamp()*kSubStampsPerStamp + ts.SubStamp();
+  }
+
+  IOVTimeStamp DBSQLite::DecodeTime(long long t) {
+    return IOVTimeStamp(t/kSubStampsPerStamp, t%kSubStampsPerStamp);
+  }
+
+  //=============================================
+  // DBSQLiteReader
+  //=============================================
+  DBSQLiteReader::DBSQLiteReader(const std::string& file, const std::string& folder, const std::string& tag) :
+    fDB(nullptr), fFile(file), fFolder(folder), fTag(tag), fHasEndTime(false) {
+
+    if (sqlite3_open_v2(fFile.c_str(), &fDB, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+      std::string msg = "Cannot open SQLite conditions file " + fFile + ": " + sqlite3_errmsg(fDB);
+      sqlite3_close(fDB);
+      throw WebError(msg);
+    }
+    fHasEndTime = HasColumn(fDB, fFolder + "_iovs", "end_time");
+  }
+
+  DBSQLiteReader::~DBSQLiteReader() {
+    sqlite3_close(fDB);
+  }
+
+  void DBSQLiteReader::SetChannelFilter(const DBChannelFilter& filter) {
+
+    std::lock_guard<std::mutex> lock(fMutex);
+    fChannelSelection.clear();
+    if (filter.Empty()) return;
+
+    //the channel is the first column after __iov_id, whatever its name
+    std::string channel;
+    {
+      Statement stmt(fDB, "SELECT * FROM " + Quote(fFolder + "_data") + " LIMIT 0");
+      if (sqlite3_column_count(stmt.get()) < 2) {
+        throw WebError("SQLite table of folder " + fFolder + " in " + fFile + " has no channel column.");
+      }
+      channel = Quote(sqlite3_column_name(stmt.get(), 1));
+    }
+    for (const DBChannelFilter::Range_t& range : filter.Ranges()) {
+      fChannelSelection += fChannelSelection.empty() ? " AND (" : " OR ";
+      fChannelSelection += channel + " BETWEEN " + std::to_string(range.first) + " AND " + std::to_string(range.second);
+    }
+    fChannelSelection += ")";
+  }
+
+  std::shared_ptr<const DBDataset> DBSQLiteReader::Fetch(const IOVTimeStamp& ts) const {
+
+    std::lock_guard<std::mutex> lock(fMutex);
+
+    const long long t = DBSQLite::EncodeTime(ts);
+    const std::string iovs = IOVSelection(fFolder, fTag, fHasEndTime);
+
+    //latest IOV starting at or before the requested time
+    long long iov_id = 0, begin_time = 0;
+    IOVTimeStamp end = IOVTimeStamp::MaxTimeStamp();
+    {
+      Statement stmt(fDB, "SELECT iov_id, begin_time, end_time FROM (" + iovs + ") WHERE begin_time <= ?1"
+                          " ORDER BY begin_time DESC, iov_id DESC LIMIT 1");
+      sqlite3_bind_int64(stmt.get(), 1, t);
+      if (!fTag.empty()) sqlite3_bind_text(stmt.get(), 2, fTag.c_str(), -1, SQLITE_TRANSIENT);
+      if (sqlite3_step(stmt.get()) != SQLITE_ROW) {
+        throw WebError("Time " + ts.DBStamp() + ": Data not found in " + fFile + " for folder " + fFolder + ".");
+      }
+      iov_id     = sqlite3_column_int64(stmt.get(), 0);
+      begin_time = sqlite3_column_int64(stmt.get(), 1);
+      end        = IOVEnd(stmt.get(), 2, end);
+    }
+
+    //it lasts until its recorded end, or until the next one begins
+    {
+      Statement stmt(fDB, "SELECT MIN(begin_time) FROM (" + iovs + ") WHERE begin_time > ?1");
+      sqlite3_bind_int64(stmt.get(), 1, begin_time);
+      if (!fTag.empty()) sqlite3_bind_text(stmt.get(), 2, fTag.c_str(), -1, SQLITE_TRANSIENT);
+      if (sqlite3_step(stmt.get()) == SQLITE_ROW && sqlite3_column_type(stmt.get(), 0) != SQLITE_NULL) {
+        const IOVTimeStamp next = DBSQLite::DecodeTime(sqlite3_column_int64(stmt.get(), 0));
+        if (next < end) end = next;
+      }
+    }
+
+    //the time falls in a gap between IOVs
+    if (ts >= end) {
+      throw WebError("Time " + ts.DBStamp() + ": Data not found in " + fFile + " for folder " + fFolder + ".");
+    }
+
+    //with a channel filter, an IOV without rows of those channels is served with no row
+    std::shared_ptr<const DBDataset> data = this->ReadPayload(iov_id, DBSQLite::DecodeTime(begin_time), end);
+    if (data->NRows() < 1 && fChannelSelection.empty()) {
+      throw WebError("Time " + ts.DBStamp() + ": Data not found in " + fFile + " for folder " + fFolder + ".");
+    }
+    return data;
+  }
+
+  std::vector<std::shared_ptr<const DBDataset>> DBSQLiteReader::FetchRange(const IOVTimeStamp& begin,
+                                                                           const IOVTimeStamp& end) const {
+
+    std::lock_guard<std::mutex> lock(fMutex);
+
+    //all visible IOVs in time order; for IOVs starting at the same time the
+    //latest entry wins, as in Fetch()
+    struct IOV {
+      long long    fBeginTime;
+      long long    fID;
+      IOVTimeStamp fEnd;       //Recorded end, MaxTimeStamp() if none
+    };
+    std::vector<IOV> iovs;
+    {
+      Statement stmt(fDB, "SELECT begin_time, iov_id, end_time FROM (" + IOVSelection(fFolder, fTag, fHasEndTime) + ")"
+                          " ORDER BY begin_time, iov_id");
+      if (!fTag.empty()) sqlite3_bind_text(stmt.get(), 2, fTag.c_str(), -1, SQLITE_TRANSIENT);
+      while (sqlite3_step(stmt.get()) == SQLITE_ROW) {
+        IOV iov{sqlite3_column_int64(stmt.get(), 0), sqlite3_column_int64(stmt.get(), 1),
+                IOVEnd(stmt.get(), 2, IOVTimeStamp::MaxTimeStamp())};
+        if (!iovs.empty() && iovs.back().fBeginTime == iov.fBeginTime) iovs.back() = iov;
+        else iovs.push_back(iov);
+      }
+    }
+
+    std::vector<std::shared_ptr<const DBDataset>> datasets;
+    for (size_t i=0; i < iovs.size(); ++i) {
+      const IOVTimeStamp iov_begin = DBSQLite::DecodeTime(iovs[i].fBeginTime);
+      IOVTimeStamp iov_end = iovs[i].fEnd;
+      if (i+1 < iovs.size() && DBSQLite::DecodeTime(iovs[i+1].fBeginTime) < iov_end) {
+        iov_end = DBSQLite::DecodeTime(iovs[i+1].fBeginTime);
+      }
+      if (iov_end <= begin || iov_begin > end) continue;
+      std::shared_ptr<const DBDataset> data = this->ReadPayload(iovs[i].fID, iov_begin, iov_end);
+      if (data->NRows() > 0 || !fChannelSelection.empty()) datasets.push_back(std::move(data)); //as Fetch() does
+    }
+    return datasets;
+  }
+
+  std::shared_ptr<const DBDataset> DBSQLiteReader::ReadPayload(long long iov_id, const IOVTimeStamp& begin,
+                                                               const IOVTimeStamp& end) const {
+
+    //payload, skipping the leading __iov_id column
+    Statement stmt(fDB, "SELECT * FROM " + Quote(fFolder + "_data") + " WHERE __iov_id = ?1" + fChannelSelection
+                        + " ORDER BY 2");
+    sqlite3_bind_int64(stmt.get(), 1, iov_id);
+
+    const int ncols = sqlite3_column_count(stmt.get()) - 1;
+    std::vector<std::string> names, types;
+    for (int c=0; c < ncols; ++c) {
+      names.push_back(sqlite3_column_name(stmt.get(), c+1));
+      const char* type = sqlite3_column_decltype(stmt.get(), c+1);
+      types.push_back(type ? type : "text");
+    }
+
+    auto data = std::make_shared<DBDataset>(begin, end, names, types);
+    std::vector<const char*> fields(ncols);
+    std::vector<std::array<char, 32>> numbers(ncols);
+    int status;
+    while ((status = sqlite3_step(stmt.get())) == SQLITE_ROW) {
+      for (int c=0; c < ncols; ++c) {
+        //the text SQLite makes of a real keeps 15 digits; 17 give back the very same double
+        if (sqlite3_column_type(stmt.get(), c+1) == SQLITE_FLOAT) {
+          std::snprintf(numbers[c].data(), numbers[c].size(), "%.17g", sqlite3_column_double(stmt.get(), c+1));
+          fields[c] = numbers[c].data();
+          continue;
+        }
+        const unsigned char* text = sqlite3_column_text(stmt.get(), c+1);
+        fields[c] = text ? (const char*)text : "";
+      }
+      data->AddRow(fields.data());
+    }
+    if (status != SQLITE_DONE) {
+      throw WebError("SQLite error reading folder " + fFolder + " from " + fFile + ": " + sqlite3_errmsg(fDB));
+    }
+    data->Finalize();
+
+    return data;
+  }
+
+  //=============================================
+  // DBSQLiteWriter
+  //=============================================
+  DBSQLiteWriter::DBSQLiteWriter(const std::string& file, const std::string& folder) :
+    fDB(nullptr), fFile(file), fFolder(folder), fHasTables(false) {
+
+    if (sqlite3_open_v2(fFile.c_str(), &fDB, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+      std::string msg = "Cannot open SQLite conditions file " + fFile + ": " + sqlite3_errmsg(fDB);
+      sqlite3_close(fDB);
+      throw WebError(msg);
+    }
+  }
+
+  DBSQLiteWriter::~DBSQLiteWriter() {
+    sqlite3_close(fDB);
+  }
+
+  void DBSQLiteWriter::CreateTables(const DBDataset& data) {
+
+    Execute(fDB, "CREATE TABLE IF NOT EXISTS " + Quote(fFolder + "_iovs")
+                 + " (iov_id INTEGER PRIMARY KEY, begin_time INTEGER NOT NULL, end_time INTEGER,"
+                 + " active INTEGER NOT NULL DEFAULT 1)");
+    if (!HasColumn(fDB, fFolder + "_iovs", "end_time")) {
+      Execute(fDB, "ALTER TABLE " + Quote(fFolder + "_iovs") + " ADD COLUMN end_time INTEGER");
+    }
+    Execute(fDB, "CREATE INDEX IF NOT EXISTS " + Quote(fFolder + "_iovs_begin_time")
+                 + " ON " + Quote(fFolder + "_iovs") + " (begin_time)");
+    Execute(fDB, "CREATE TABLE IF NOT EXISTS " + Quote(fFolder + "_tag_iovs")
+                 + " (tag TEXT NOT NULL, iov_id INTEGER NOT NULL)");
+    Execute(fDB, "CREATE INDEX IF NOT EXISTS " + Quote(fFolder + "_tag_iovs_tag")
+                 + " ON " + Quote(fFolder + "_tag_iovs") + " (tag, iov_id)");
+
+    std::string sql = "CREATE TABLE IF NOT EXISTS " + Quote(fFolder + "_data") + " (__iov_id INTEGER NOT NULL";
+    for (size_t c=0; c < data.NColumns(); ++c) {
+      sql += ", " + Quote(data.ColumnNames()[c]) + " " + SQLType(data.ColumnTypes()[c]);
+    }
+    Execute(fDB, sql + ")");
+    Execute(fDB, "CREATE INDEX IF NOT EXISTS " + Quote(fFolder + "_data_iov_channel")
+                 + " ON " + Quote(fFolder + "_data") + " (__iov_id, " + Quote(data.ColumnNames()[0]) + ")");
+
+    fHasTables = true;
+  }
+
+  void DBSQLiteWriter::Write(const DBDataset& data, const std::string& tag) {
+
+    if (!fHasTables) this->CreateTables(data);
+
+    Execute(fDB, "BEGIN");
+    try {
+      long long iov_id;
+      {
+        Statement stmt(fDB, "INSERT INTO " + Quote(fFolder + "_iovs") + " (begin_time, end_time, active) VALUES (?1, ?2, 1)");
+        sqlite3_bind_int64(stmt.get(), 1, DBSQLite::EncodeTime(data.Begin()));
+        if (data.End() == IOVTimeStamp::MaxTimeStamp()) sqlite3_bind_null(stmt.get(), 2);
+        else sqlite3_bind_int64(stmt.get(), 2, DBSQLite::EncodeTime(data.End()));
+        if (sqlite3_step(stmt.get()) != SQLITE_DONE) throw WebError(std::string("SQLite error: ") + sqlite3_errmsg(fDB));
+        iov_id = sqlite3_last_insert_rowid(fDB);
+      }
+
+      if (!tag.empty()) {
+        Statement stmt(fDB, "INSERT INTO " + Quote(fFolder + "_tag_iovs") + " (tag, iov_id) VALUES (?1, ?2)");
+        sqlite3_bind_text(stmt.get(), 1, tag.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt.get(), 2, iov_id);
+        if (sqlite3_step(stmt.get()) != SQLITE_DONE) throw WebError(std::string("SQLite error: ") + sqlite3_errmsg(fDB));
+      }
+
+      std::string sql = "INSERT INTO " + Quote(fFolder + "_data") + " VALUES (?1";
+      for (size_t c=0; c < data.NColumns(); ++c) sql += ", ?" + std::to_string(c+2);
+      Statement stmt(fDB, sql + ")");
+
+      for (size_t row=0; row < data.NRows(); ++row) {
+        sqlite3_reset(stmt.get());
+        sqlite3_bind_int64(stmt.get(), 1, iov_id);
+        for (size_t c=0; c < data.NColumns(); ++c) {
+          switch (data.Kind(c)) {
+            case DBDataset::kLongColumn   :
+            case DBDataset::kBoolColumn   :
+              sqlite3_bind_int64(stmt.get(), c+2, data.LongValue(row, c));
+              break;
+            case DBDataset::kDoubleColumn :
+              sqlite3_bind_double(stmt.get(), c+2, data.DoubleValue(row, c));
+              break;
+            case DBDataset::kStringColumn :
+            case DBDataset::kArrayColumn  :
+              sqlite3_bind_text(stmt.get(), c+2, data.StringValue(row, c).c_str(), -1, SQLITE_TRANSIENT);
+              break;
+          }
+        }
+        if (sqlite3_step(stmt.get()) != SQLITE_DONE) throw WebError(std::string("SQLite error: ") + sqlite3_errmsg(fDB));
+      }
+    }
+    catch (...) {
+      sqlite3_exec(fDB, "ROLLBACK", nullptr, nullptr, nullptr);
+      throw;
+    }
+    Execute(fDB, "COMMIT");
+  }
+
+}//end namespace lariov
@@ -0,0 +1,111 @@
+/**
+ * \file DBSQLiteFile.h
+ *
+ * \ingroup WebDBI
+ *
+ * \brief Class def header for classes DBSQLiteReader and DBSQLiteWriter
+ */
+
+/** \addtogroup WebDBI
+
+    @{*/
+#ifndef WEBDBI_DBSQLITEFILE_H
+#define WEBDBI_DBSQLITEFILE_H
+
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Providers/DBChannelFilter.h"
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct sqlite3;
+
+namespace lariov {
+
+  /**
+     Layout of a conditions folder in a SQLite file, mirroring the server side:
+
+       <folder>_iovs     (iov_id, begin_time, end_time, active)  one entry per IOV
+       <folder>_tag_iovs (tag, iov_id)                           IOVs belonging to each tag
+       <folder>_data     (__iov_id, channel, ...)                payload rows, one column per folder column
+
+     begin_time and end_time count IOVTimeStamp substamps, i.e. stamp*1000000 + substamp.
+     An IOV ends at end_time, or where the next one (within the same tag, if any) begins
+     if that is earlier; end_time is null for open-ended IOVs, and absent from files
+     written before it was introduced.  Both begin_time and (__iov_id, channel) are indexed.
+  */
+  namespace DBSQLite {
+    long long EncodeTime(const IOVTimeStamp& ts);
+    IOVTimeStamp DecodeTime(long long t);
+  }
+
+  /**
+     \class DBSQLiteReader
+     Retrieves folder payloads from a local SQLite file instead of the web server
+  */
+  class DBSQLiteReader {
+
+    public:
+
+      DBSQLiteReader(const std::string& file, const std::string& folder, const std::string& tag = "");
+      ~DBSQLiteReader();
+
+      DBSQLiteReader(const DBSQLiteReader&) = delete;
+      DBSQLiteReader& operator=(const DBSQLiteReader&) = delete;
+
+      /// Only read the rows of these channels, selected by the query through the (iov, channel) index
+      void SetChannelFilter(const DBChannelFilter& filter);
+
+      /// Return the dataset valid at the given time; throws WebError if there is none, or if it has no row and there is no filter
+      std::shared_ptr<const DBDataset> Fetch(const IOVTimeStamp& ts) const;
+
+      /// Return the datasets of all IOVs overlapping [begin, end], in time order; empty IOVs are left out unless filtered
+      std::vector<std::shared_ptr<const DBDataset>> FetchRange(const IOVTimeStamp& begin, const IOVTimeStamp& end) const;
+
+    private:
+
+      /// Read the payload of one IOV; the caller holds fMutex
+      std::shared_ptr<const DBDataset> ReadPayload(long long iov_id, const IOVTimeStamp& begin,
+                                                   const IOVTimeStamp& end) const;
+
+      sqlite3*           fDB;
+      std::string        fFile;
+      std::string        fFolder;
+      std::string        fTag;
+      bool               fHasEndTime;       //The file records where IOVs end
+      std::string        fChannelSelection; //SQL condition on the channel column, empty to read all rows
+      mutable std::mutex fMutex;
+  };
+
+  /**
+     \class DBSQLiteWriter
+     Writes folder payloads into a SQLite file readable by DBSQLiteReader
+  */
+  class DBSQLiteWriter {
+
+    public:
+
+      DBSQLiteWriter(const std::string& file, const std::string& folder);
+      ~DBSQLiteWriter();
+
+      DBSQLiteWriter(const DBSQLiteWriter&) = delete;
+      DBSQLiteWriter& operator=(const DBSQLiteWriter&) = delete;
+
+      /// Add one IOV, optionally attached to a tag; tables are created on first use
+      void Write(const DBDataset& data, const std::string& tag = "");
+
+    private:
+
+      void CreateTables(const DBDataset& data);
+
+      sqlite3*    fDB;
+      std::string fFile;
+      std::string fFolder;
+      bool        fHasTables;
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
@@ -0,0 +1,221 @@
+#include "DBWebReader.h"
+#include "DBConnectionPool.h"
+#include "WebDBIConstants.h"
+#include "WebError.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <curl/curl.h>
+
+namespace {
+
+  const unsigned long long kMaxChannel = std::numeric_limits<lariov::DBChannelID_t>::max();
+
+  /// Split a line into fields in place; each field ends up NUL-terminated, so end must be writable
+  void SplitFields(char* begin, char* end, std::vector<const char*>& fields) {
+
+    fields.clear();
+    char* in = begin;
+    while (true) {
+      char* out = in;
+      const char* field = out;
+      bool quoted = (in != end && *in == '"');
+      if (quoted) ++in;
+      int depth = 0;
+      while (in != end) {
+        const char c = *in;
+        if (quoted) {
+          if (c == '"') {
+            ++in;
+            if (in != end && *in == '"') *out++ = *in++; //doubled quote
+            else quoted = false;
+            continue;
+          }
+        }
+        else {
+          if (c == ',' && depth == 0) break;
+          if (c == '[') ++depth;
+          else if (c == ']' && depth > 0) --depth;
+        }
+        *out++ = c;
+        ++in;
+      }
+      const bool more = (in != end);
+      *out = '\0';
+      fields.push_back(field);
+      if (!more) return;
+      ++in;
+    }
+  }
+
+  struct Transfer {
+    Transfer(const lariov::DBChannelFilter& filter) : fHandle(nullptr), fParser(filter) {}
+
+    CURL*                       fHandle;
+    lariov::DBWebReader::Parser fParser;
+    std::string                 fReason;   //Reason phrase of the status line
+    std::string                 fBody;     //Start of the body of an error response
+    std::exception_ptr          fError;
+  };
+
+  size_t WriteBody(char* chunk, size_t size, size_t nmemb, void* userdata) {
+
+    Transfer& transfer = *static_cast<Transfer*>(userdata);
+    const size_t n = size*nmemb;
+    long status = 0;
+    curl_easy_getinfo(transfer.fHandle, CURLINFO_RESPONSE_CODE, &status);
+    if (status != 200) {
+      if (transfer.fBody.size() < 256) transfer.fBody.append(chunk, std::min<size_t>(n, 256));
+      return n;
+    }
+    try {
+      transfer.fParser.Feed(chunk, n);
+    }
+    catch (...) {
+      transfer.fError = std::current_exception();
+      return 0; //aborts the transfer
+    }
+    return n;
+  }
+
+  size_t ReadHeader(char* line, size_t size, size_t nitems, void* userdata) {
+
+    Transfer& transfer = *static_cast<Transfer*>(userdata);
+    const size_t n = size*nitems;
+    std::string header(line, n);
+    if (header.compare(0, 5, "HTTP/") == 0) {
+      //status line of the last response, after any redirection: "HTTP/1.1 503 Service Unavailable"
+      size_t pos = header.find(' ');
+      pos = (pos == std::string::npos) ? pos : header.find(' ', pos+1);
+      transfer.fReason = (pos == std::string::npos) ? "" : header.substr(pos+1);
+      while (!transfer.fReason.empty() && std::isspace((unsigned char)transfer.fReason.back())) transfer.fReason.pop_back();
+    }
+    return n;
+  }
+}
+
+namespace lariov {
+
+  int DBWebReader::Fetch(const std::string& url, int timeout, std::shared_ptr<DBDataset>& data,
+                         std::string& message, const DBChannelFilter& filter /*= DBChannelFilter()*/) {
+
+    data.reset();
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+    DBConnectionPool::Connection connection = DBConnectionPool::Get(url, timeout);
+    CURL* curl = connection.Handle();
+    if (!curl) {
+      message = "no connection available within " + std::to_string(timeout) + " s";
+      return 0;
+    }
+
+    //the wait for a connection counts against the timeout
+    const long remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      deadline - std::chrono::steady_clock::now()).count();
+    if (remaining_ms <= 0) {
+      message = "no time left within " + std::to_string(timeout) + " s after waiting for a connection";
+      return 0;
+    }
+
+    Transfer transfer(filter);
+    transfer.fHandle = curl;
+    char error[CURL_ERROR_SIZE] = "";
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, ""); //every encoding this libcurl decodes
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, remaining_ms);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);           //fetches run on several threads
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "larevt-CalibrationDBI");
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, error);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteBody);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, ReadHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer);
+
+    CURLcode result = curl_easy_perform(curl);
+    if (transfer.fError) std::rethrow_exception(transfer.fError);
+    if (result != CURLE_OK) {
+      message = error[0] ? error : curl_easy_strerror(result);
+      return 0;
+    }
+
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    if (status != 200) {
+      message = transfer.fReason;
+      const std::string body = transfer.fBody.substr(0, transfer.fBody.find('\n'));
+      if (!body.empty()) message += (message.empty() ? "" : ": ") + body;
+      return (int)status;
+    }
+
+    data = transfer.fParser.Finish();
+    return 200;
+  }
+
+  //=============================================
+  // DBWebReader::Parser
+  //=============================================
+  void DBWebReader::Parser::Feed(const char* chunk, size_t size) {
+
+    fPartial.append(chunk, size);
+    char* line = &fPartial[0];
+    char* const stop = line + fPartial.size();
+    while (char* eol = (char*)std::memchr(line, '\n', stop - line)) {
+      this->ParseLine(line, eol);
+      line = eol + 1;
+    }
+    fPartial.erase(0, line - fPartial.data());
+  }
+
+  std::shared_ptr<DBDataset> DBWebReader::Parser::Finish() {
+
+    if (!fPartial.empty()) this->Feed("\n", 1);
+    //no row of the filtered channels in this IOV is an answer too: the IOV is kept, with no row
+    if (!fData || (fData->NRows() == 0 && fFilter.Empty())) return nullptr;
+    fData->Finalize();
+    return std::move(fData);
+  }
+
+  void DBWebReader::Parser::ParseLine(char* begin, char* end) {
+
+    if (end != begin && end[-1] == '\r') --end;
+    if (end == begin) return;
+
+    const size_t line = fNLines++;
+
+    //a row of a channel we do not need is not worth splitting
+    if (line >= kNUMBER_HEADER_ROWS && !fFilter.Empty()) {
+      const char* digits = (*begin == '"') ? begin + 1 : begin;
+      const char* c = digits;
+      unsigned long long channel = 0;
+      while (c != end && std::isdigit((unsigned char)*c) && channel <= kMaxChannel) channel = 10*channel + (*c++ - '0');
+      if (c != digits && (channel > kMaxChannel || !fFilter.Contains(channel))) return;
+    }
+
+    SplitFields(begin, end, fFields);
+
+    if (line < kNUMBER_HEADER_ROWS) {
+      if (line < 2) fHeader.emplace_back(fFields[0]);
+      else if (line == 2) fNames.assign(fFields.begin(), fFields.end());
+      else {
+        std::vector<std::string> types(fFields.begin(), fFields.end());
+        if (types.size() != fNames.size()) throw WebError("DBWebReader: column names and types do not match");
+        IOVTimeStamp start = IOVTimeStamp::GetFromString(fHeader[0]);
+        IOVTimeStamp end = (fHeader[1] == "-") ? IOVTimeStamp::MaxTimeStamp() : IOVTimeStamp::GetFromString(fHeader[1]);
+        fData = std::make_shared<DBDataset>(start, end, fNames, types);
+      }
+      return;
+    }
+
+    if (fFields.size() != fNames.size()) {
+      throw WebError("DBWebReader: row " + std::to_string(line - kNUMBER_HEADER_ROWS) + " has "
+                     + std::to_string(fFields.size()) + " columns instead of " + std::to_string(fNames.size()));
+    }
+    fData->AddRow(fFields.data());
+  }
+
+}//end namespace lariov
@@ -0,0 +1,83 @@
+/**
+ * \file DBWebReader.h
+ *
+ * \ingroup WebDBI
+ *
+ * \brief Class def header for a class DBWebReader
+ */
+
+/** \addtogroup WebDBI
+
+    @{*/
+#ifndef WEBDBI_DBWEBREADER_H
+#define WEBDBI_DBWEBREADER_H
+
+#include "larevt/CalibrationDBI/Providers/DBChannelFilter.h"
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lariov {
+
+  /**
+     \class DBWebReader
+     Retrieves folder payloads from the conditions web server.
+
+     The response is requested in any compressed encoding libcurl can decode
+     (gzip, zstd, ...) and rows are decoded as the chunks arrive, so decoding
+     overlaps the transfer and the body is never held as a whole.  The body
+     is CSV text: the start and end of the IOV ("-" for open-ended), the
+     column names and types, then one row per channel.  Fields holding commas
+     are enclosed in double quotes or, for arrays, in brackets.  Rows of
+     channels outside a channel filter are dropped before they are split.
+  */
+  class DBWebReader {
+
+    public:
+
+      /**
+         Retrieve url, giving up after timeout seconds, including any wait for a
+         connection to the server (see DBConnectionPool).  Returns the HTTP status,
+         or 0 if no answer came, with the reason in message.  data is only set
+         with status 200, and is null if the body holds no row; with a filter,
+         a body without rows of its channels gives a dataset with no row
+         instead.  Throws WebError if the body cannot be decoded.  Safe to
+         call from any thread.
+      */
+      static int Fetch(const std::string& url, int timeout, std::shared_ptr<DBDataset>& data,
+                       std::string& message, const DBChannelFilter& filter = DBChannelFilter());
+
+      /**
+         Decodes the body of a response, fed in chunks of any size.
+      */
+      class Parser {
+
+        public:
+
+          /// Only rows of the channels of filter are kept
+          explicit Parser(const DBChannelFilter& filter = DBChannelFilter()) : fNLines(0), fFilter(filter) {}
+
+          /// Decode the complete lines in this chunk; keep the rest for the next one
+          void Feed(const char* chunk, size_t size);
+
+          /// Decode what is left after the last chunk and return the dataset, null if there was no row and no filter
+          std::shared_ptr<DBDataset> Finish();
+
+        private:
+
+          void ParseLine(char* begin, char* end);
+
+          std::string                fPartial;   //Start of a line continued in the next chunk
+          size_t                     fNLines;
+          DBChannelFilter            fFilter;
+          std::vector<std::string>   fHeader;    //Start and end times
+          std::vector<std::string>   fNames;
+          std::shared_ptr<DBDataset> fData;
+          std::vector<const char*>   fFields;
+      };
+  };
+}
+
+#endif
+/** @} */ // end of doxygen group
@@ -1,9 +1,13 @@
 #include "fhiclcpp/ParameterSet.h"
+#include "larevt/CalibrationDBI/IOVData/TimeStampDecoder.h"
 #include "larevt/CalibrationDBI/Providers/DBFolder.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
 
 #include "DatabaseRetrievalAlg.h"
 
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace lariov {
 
@@ -13,6 +17,66 @@ namespace lariov {
     std::string foldername = p.get<std::string>("DBFolderName");
     std::string url        = p.get<std::string>("DBUrl");
     std::string tag        = p.get<std::string>("DBTag", "");
-    fFolder.reset(new DBFolder(foldername, url, tag));
+    bool        usesqlite  = p.get<bool>("UseSQLite", false);
+    fFolder.reset(new DBFolder(foldername, url, tag, usesqlite));
+    //the provider publishes a new snapshot too: there is nothing to patch from
+    fSnapshotData.reset();
+    std::string cachedir   = p.get<std::string>("CacheDirectory", "");
+    bool        sharedmem  = p.get<bool>("SharedMemoryCache", false);
+    if (sharedmem && cachedir.empty()) cachedir = DBDatasetCache::SharedMemoryDirectory();
+    fFolder->SetCacheDirectory(cachedir, sharedmem);
+    fFolder->SetPrefetchWindow(p.get<unsigned long>("PrefetchWindow", 0));
+    fFolder->SetTimeout(p.get<int>("FetchTimeout", 240));
+    fFolder->SetRetries(p.get<unsigned int>("FetchRetries", 2), p.get<unsigned long>("RetryDelay", 500));
+    fFolder->SetStaleDeadline(p.get<unsigned long>("StaleDeadline", 0));
+    fFolder->SetMaxStaleAge(p.get<unsigned long>("MaxStaleAge", 600));
+    fLazyRows = p.get<bool>("LazyRows", false);
+
+    //a job using part of the detector reads only its channels: [first, last] ranges and single channels
+    DBChannelFilter channels;
+    for (auto const& range : p.get<std::vector<std::pair<DBChannelID_t, DBChannelID_t>>>("ChannelRanges", {})) {
+      channels.AddRange(range.first, range.second);
+    }
+    for (DBChannelID_t ch : p.get<std::vector<DBChannelID_t>>("ChannelList", {})) channels.AddChannel(ch);
+    if (!channels.Empty()) fFolder->SetChannelFilter(channels, p.get<bool>("ServerChannelFilter", false));
+
+    fPreloadRun = p.get<bool>("PreloadRun", false);
+    fPreloadHorizon = p.get<unsigned long>("PreloadHorizon", kDefaultPreloadHorizon);
+    std::string preload_start = p.get<std::string>("PreloadStart", "");
+    fPreloadSpan = !preload_start.empty();
+    if (fPreloadSpan) {
+      fPreloadBegin = IOVTimeStamp::GetFromString(preload_start);
+      fPreloadEnd   = IOVTimeStamp::GetFromString(p.get<std::string>("PreloadEnd"));
+    }
+  }
+
+  void DatabaseRetrievalAlg::PreloadForRun(DBTimeStamp_t run_begin, DBTimeStamp_t run_end) {
+
+    if (!fPreloadSpan && !fPreloadRun) return;
+    if (fPreloadSpan && fFolder->NPreloaded() > 0) return;
+
+    try {
+      if (fPreloadSpan) {
+        fFolder->Preload(fPreloadBegin, fPreloadEnd);
+        return;
+      }
+      if (run_begin == 0 || (run_end <= run_begin && fPreloadHorizon == 0)) {
+        mf::LogInfo("DatabaseRetrievalAlg") << "Run time span unknown; IOVs of folder "
+                                            << fFolder->FolderName() << " are fetched as events need them";
+        return;
+      }
+      const IOVTimeStamp begin = TimeStampDecoder::DecodeTimeStamp(run_begin);
+      if (run_end > run_begin) {
+        fFolder->Preload(begin, TimeStampDecoder::DecodeTimeStamp(run_end));
+      }
+      else {
+        //the end of a run is only known once it is over
+        fFolder->Preload(begin, IOVTimeStamp(begin.Stamp() + fPreloadHorizon, begin.SubStamp()));
+      }
+    }
+    catch (std::exception const& e) {
+      mf::LogWarning("DatabaseRetrievalAlg") << "Preload of folder " << fFolder->FolderName() << " failed, IOVs are"
+                                             << " fetched as events need them: " << e.what();
+    }
   }
 }
@@ -14,8 +14,13 @@
 #ifndef DATABASERETRIEVALALG_H
 #define DATABASERETRIEVALALG_H
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 #include "DBFolder.h"
+#include "DBRowSchema.h"
+#include "larevt/CalibrationDBI/IOVData/IOVDataConstants.h"
+#include "larevt/CalibrationDBI/IOVData/Snapshot.h"
 
 namespace fhicl { class ParameterSet; }
 
@@ -33,10 +38,16 @@ namespace lariov {
     public:
 
       /// Constructors
-      DatabaseRetrievalAlg(const std::string& foldername, const std::string& url, const std::string& tag="") :
-        fFolder(new DBFolder(foldername, url, tag)) {}
-
-      DatabaseRetrievalAlg(fhicl::ParameterSet const& p) {
+      DatabaseRetrievalAlg(const std::string& foldername, const std::string& url, const std::string& tag="",
+                           bool usesqlite=false) :
+        fFolder(new DBFolder(foldername, url, tag, usesqlite)), fDataSource(DataSource::Database), fLazyRows(false),
+        fPreloadRun(false), fPreloadSpan(false), fPreloadHorizon(kDefaultPreloadHorizon),
+        fPreloadBegin(IOVTimeStamp::MinTimeStamp()), fPreloadEnd(IOVTimeStamp::MinTimeStamp()) {}
+
+      DatabaseRetrievalAlg(fhicl::ParameterSet const& p) :
+        fDataSource(DataSource::Database), fLazyRows(false), fPreloadRun(false), fPreloadSpan(false),
+        fPreloadHorizon(kDefaultPreloadHorizon),
+        fPreloadBegin(IOVTimeStamp::MinTimeStamp()), fPreloadEnd(IOVTimeStamp::MinTimeStamp()) {
         this->Reconfigure(p);
       }
 
@@ -51,11 +62,70 @@ namespace lariov {
         return fFolder->UpdateData(ts);
       }
 
+      /// Only read the rows of these channels, see DBFolder::SetChannelFilter; call before the first update
+      void SetChannelFilter(const DBChannelFilter& filter, bool serverSide = false) {
+        fFolder->SetChannelFilter(filter, serverSide);
+      }
+
+      /// Start fetching the next IOV in the background, e.g. at the start of a subrun
+      void PrefetchFolder() {
+        fFolder->PrefetchNext();
+      }
+
+      /// Start fetching the next IOV in the background if ts is within the PrefetchWindow of the end of the current one
+      void MaybePrefetch(const IOVTimeStamp& ts) {
+        fFolder->MaybePrefetch(ts);
+      }
+
+      /**
+        Fetch all the IOVs needed for a run up front, as configured: the span
+        given by PreloadStart and PreloadEnd (once), or with PreloadRun the
+        time span of each run.  The end of a run is not known when it begins
+        (run_end is 0): the span then reaches PreloadHorizon seconds past the
+        start of the run, and later IOVs are fetched as events need them.
+        Run times are raw event times.  A failed preload is reported and
+        leaves the IOVs to be fetched as events need them.  Call at the start
+        of a run, while no event is processed.
+      */
+      void PreloadForRun(DBTimeStamp_t run_begin, DBTimeStamp_t run_end);
+
+      /// Preload the IOVs of each run, up to horizon seconds from its start if its end is unknown
+      void SetPreloadRun(bool preload, unsigned long horizon = kDefaultPreloadHorizon) {
+        fPreloadRun = preload;
+        fPreloadHorizon = horizon;
+      }
+
+      /// Number of IOVs held by the last preload
+      size_t NPreloaded() const {return fFolder->NPreloaded();}
+
+      /// Seconds preloaded from the start of a run whose end is not known
+      static constexpr unsigned long kDefaultPreloadHorizon = 86400;
+
       /// Get connection information
       const std::string& URL() const {return fFolder->URL();}
       const std::string& FolderName() const {return fFolder->FolderName();}
       const std::string& Tag() const {return fFolder->Tag();}
 
+      /**
+        Decode the rows of a payload only as their channels are first accessed,
+        instead of all of them at each IOV update: for jobs that use a small
+        part of the detector.  An IOV switch then costs nothing per channel: the
+        payload is not compared with the previous one, so every channel counts
+        as changed (AllChannelsChanged() of the providers), and the snapshot shares the
+        channel list of the payload.  The column arrays are not built either.
+      */
+      void SetLazyRows(bool lazy) {fLazyRows = lazy;}
+      bool LazyRows() const {return fLazyRows;}
+
+      /// True if the data come from the conditions database, i.e. follow the event time
+      bool UsesDatabase() const {return fDataSource == DataSource::Database;}
+
+      /// True if the data served from the database are valid at the given time, i.e. no update is needed
+      bool IsCurrent(const IOVTimeStamp& ts) const {return ts >= this->Begin() && ts < this->End();}
+
+      /// True while the folder keeps serving the previous IOV because the next payload is late
+      bool ServingStaleData() const {return fFolder->IsStale();}
+
       /// Get Timestamp information
       const IOVTimeStamp& Begin() const {return fFolder->CachedStart();}
       const IOVTimeStamp& End() const   {return fFolder->CachedEnd();}
@@ -63,7 +133,61 @@ namespace lariov {
 
     protected:
 
+      /**
+        Build the snapshot for the payload the folder has just moved to, given
+        the one built from the previous payload.  If the two payloads compare
+        row by row, the current snapshot is copied and read(data, snapshot, &rows)
+        patches only the changed rows, which are then listed in the snapshot's
+        ChangedChannels(); otherwise read(data, snapshot, nullptr) fills an
+        empty one.  With LazyRows(), the snapshot is a lazy one over the payload
+        instead, see ReadRowsLazily, and the payloads are not compared.  current must be the last snapshot built
+        here, unless Reconfigure() was called since.  Call with the update lock held.
+      */
+      template <class T, class Read>
+      std::unique_ptr<Snapshot<T>> NextSnapshot(const Snapshot<T>& current, Read read) {
+
+        std::shared_ptr<const DBDataset> data = fFolder->CachedData();
+        std::vector<size_t> rows;
+        std::vector<DBChannelID_t> removed;
+        std::unique_ptr<Snapshot<T>> next;
+        const bool patch = !fLazyRows && fSnapshotData && data->Diff(*fSnapshotData, rows, removed);
+        if (fLazyRows) {
+          next = std::make_unique<Snapshot<T>>();
+          ReadRowsLazily(data, *next);
+        }
+        else if (patch) {
+          next = std::make_unique<Snapshot<T>>(current);
+          for (DBChannelID_t ch : removed) next->RemoveRow(ch);
+          read(*data, *next, &rows);
+        }
+        else {
+          next = std::make_unique<Snapshot<T>>();
+          read(*data, *next, nullptr);
+        }
+        if (patch) {
+          std::vector<unsigned int> changed(removed.begin(), removed.end());
+          for (size_t row : rows) changed.push_back(data->Channels()[row]);
+          std::sort(changed.begin(), changed.end());
+          next->SetChangedChannels(std::move(changed));
+        }
+        next->SetIoV(this->Begin(), this->End());
+        fSnapshotData = std::move(data);
+        return next;
+      }
+
       std::unique_ptr<DBFolder> fFolder;
+      DataSource::ds            fDataSource;   //Set by the provider's configuration
+
+    private:
+
+      std::shared_ptr<const DBDataset> fSnapshotData; //Payload the last snapshot of NextSnapshot was built from
+      bool         fLazyRows;      //NextSnapshot makes lazy snapshots
+
+      bool         fPreloadRun;    //Preload the time span of each run
+      bool         fPreloadSpan;   //Preload [fPreloadBegin, fPreloadEnd] before the first run
+      unsigned long fPreloadHorizon; //Seconds preloaded from the start of a run of unknown end
+      IOVTimeStamp fPreloadBegin;
+      IOVTimeStamp fPreloadEnd;
   };
 }
 
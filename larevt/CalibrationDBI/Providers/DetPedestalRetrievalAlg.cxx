@@ -21,21 +21,25 @@ namespace lariov {
   //constructors
   DetPedestalRetrievalAlg::DetPedestalRetrievalAlg(const std::string& foldername,
       			      			   const std::string& url,
-			      			   const std::string& tag /*=""*/) :
-    DatabaseRetrievalAlg(foldername, url, tag),
+			      			   const std::string& tag /*=""*/,
+			      			   bool usesqlite /*=false*/) :
+    DatabaseRetrievalAlg(foldername, url, tag, usesqlite),
     fEventTimeStamp(0),
-    fCurrentTimeStamp(0),
-    fDataSource(DataSource::Database) {
+    fCurrentTimeStamp(0) {
 
-    fData.Clear();
+    auto data = std::make_unique<Snapshot<DetPedestal>>();
+    data->Clear();
     IOVTimeStamp tmp = IOVTimeStamp::MaxTimeStamp();
     tmp.SetStamp(tmp.Stamp()-1, tmp.SubStamp());
-    fData.SetIoV(tmp, IOVTimeStamp::MaxTimeStamp());
+    data->SetIoV(tmp, IOVTimeStamp::MaxTimeStamp());
+    fData = std::move(data);
   }
 
 
   DetPedestalRetrievalAlg::DetPedestalRetrievalAlg(fhicl::ParameterSet const& p) :
-    DatabaseRetrievalAlg(p.get<fhicl::ParameterSet>("DatabaseRetrievalAlg")) {
+    DatabaseRetrievalAlg(p.get<fhicl::ParameterSet>("DatabaseRetrievalAlg")),
+    fEventTimeStamp(0),
+    fCurrentTimeStamp(0) {
 
     this->Reconfigure(p);
   }
@@ -43,10 +47,11 @@ namespace lariov {
   void DetPedestalRetrievalAlg::Reconfigure(fhicl::ParameterSet const& p) {
 
     this->DatabaseRetrievalAlg::Reconfigure(p.get<fhicl::ParameterSet>("DatabaseRetrievalAlg"));
-    fData.Clear();
+    auto data = std::make_unique<Snapshot<DetPedestal>>();
+    data->Clear();
     IOVTimeStamp tmp = IOVTimeStamp::MaxTimeStamp();
     tmp.SetStamp(tmp.Stamp()-1, tmp.SubStamp());
-    fData.SetIoV(tmp, IOVTimeStamp::MaxTimeStamp());
+    data->SetIoV(tmp, IOVTimeStamp::MaxTimeStamp());
 
     bool UseDB      = p.get<bool>("UseDB", false);
     bool UseFile   = p.get<bool>("UseFile", false);
@@ -87,11 +92,11 @@ namespace lariov {
 
         if (geo->SignalType(ch) == geo::kCollection) {
 	  DefaultColl.SetChannel(ch);
-	  fData.AddOrReplaceRow(DefaultColl);
+	  data->AddOrReplaceRow(DefaultColl);
 	}
 	else if (geo->SignalType(ch) == geo::kInduction) {
 	  DefaultInd.SetChannel(ch);
-	  fData.AddOrReplaceRow(DefaultInd);
+	  data->AddOrReplaceRow(DefaultInd);
 	}
 	else throw IOVDataError("Wire type is not collection or induction!");
       }
@@ -106,41 +111,28 @@ namespace lariov {
 	  << "File "<<abs_fp<<" is not found.";
       }
 
-      std::string line;
-      DetPedestal dp(0);
-      while (std::getline(file, line)) {
-        size_t current_comma = line.find(',');
-        DBChannelID_t ch = (DBChannelID_t)std::stoi(line.substr(0, current_comma));
-	float ped     = std::stof( line.substr(current_comma+1, line.find(',',current_comma+1)-(current_comma+1)) );
-
-	current_comma = line.find(',',current_comma+1);
-	float rms     = std::stof( line.substr(current_comma+1, line.find(',',current_comma+1)-(current_comma+1)) );
-
-	current_comma = line.find(',',current_comma+1);
-	float ped_err = std::stof( line.substr(current_comma+1, line.find(',',current_comma+1)-(current_comma+1)) );
-
-	current_comma = line.find(',',current_comma+1);
-	float rms_err = std::stof( line.substr(current_comma+1) );
-
-	dp.SetChannel(ch);
-	dp.SetPedMean(ped);
-        dp.SetPedMeanErr(ped_err);
-        dp.SetPedRms(rms);
-        dp.SetPedRmsErr(rms_err);
-	fData.AddOrReplaceRow(dp);
+      //binary snapshot with database column names, or text with one channel per line
+      if (DBDataset::IsBinaryFile(abs_fp)) {
+        ReadRows(*DBDataset::ReadFile(abs_fp), *data);
+      }
+      else {
+        ReadRows(*DBDataset::ReadCSVFile(abs_fp,
+                                         {"channel", "mean", "rms", "mean_err", "rms_err"},
+                                         {"bigint", "real", "real", "real", "real"}), *data);
       }
     } // if source from file
     else {
       std::cout << "Using pedestals from conditions database\n";
     }
+
+    fData = std::move(data);
   }
 
 
-  // This method saves the time stamp of the latest event.
+  // This method saves the time stamp of the latest event and validates the cached data for it.
 
   void DetPedestalRetrievalAlg::UpdateTimeStamp(DBTimeStamp_t ts) {
-    mf::LogInfo("DetPedestalRetrievalAlg") << "DetPedestalRetrievalAlg::UpdateTimeStamp called.";
-    fEventTimeStamp = ts;
+    this->Update(ts);
   }
 
   // Maybe update method cached data (public non-const version).
@@ -151,60 +143,28 @@ namespace lariov {
     return DBUpdate(ts);
   }
 
-  // Maybe update method cached data (private const version using current event time).
-
-  bool DetPedestalRetrievalAlg::DBUpdate() const {
-    return DBUpdate(fEventTimeStamp);
-  }
-
-  // Maybe update method cached data (private const version).
+  // Maybe update method cached data (private version).
   // This is the function that does the actual work of updating data from database.
 
-  bool DetPedestalRetrievalAlg::DBUpdate(DBTimeStamp_t ts) const {
-
-    bool result = false;
-    if(fDataSource == DataSource::Database && ts != fCurrentTimeStamp) {
-
-      mf::LogInfo("DetPedestalRetrievalAlg") << "DetPedestalRetrievalAlg::DBUpdate called with new timestamp.";
-      fCurrentTimeStamp = ts;
-
-      // Call non-const base class method.
+  bool DetPedestalRetrievalAlg::DBUpdate(DBTimeStamp_t ts) {
 
-      result = const_cast<DetPedestalRetrievalAlg*>(this)->UpdateFolder(ts);
-      if(result) {
+    if (fDataSource != DataSource::Database || ts == fCurrentTimeStamp.load(std::memory_order_acquire)) return false;
 
-	//DBFolder was updated, so now update the Snapshot
-	fData.Clear();
-	fData.SetIoV(this->Begin(), this->End());
+    //only one thread updates; the others wait here and find the data current
+    std::lock_guard<std::mutex> lock(fUpdateMutex);
+    if (ts == fCurrentTimeStamp.load(std::memory_order_relaxed)) return false;
 
-	std::vector<DBChannelID_t> channels;
-	fFolder->GetChannelList(channels);
-	for (auto it = channels.begin(); it != channels.end(); ++it) {
+    mf::LogInfo("DetPedestalRetrievalAlg") << "DetPedestalRetrievalAlg::DBUpdate called with new timestamp.";
 
-	  double mean, mean_err, rms, rms_err;
-	  fFolder->GetNamedChannelData(*it, "mean",     mean);
-	  fFolder->GetNamedChannelData(*it, "mean_err", mean_err);
-	  fFolder->GetNamedChannelData(*it, "rms",      rms);
-	  fFolder->GetNamedChannelData(*it, "rms_err",  rms_err);
+    bool result = fFolder->UpdateData(ts);
+    if (result) {
 
-	  DetPedestal pd(*it);
-	  pd.SetPedMean( (float)mean );
-	  pd.SetPedMeanErr( (float)mean_err );
-	  pd.SetPedRms( (float)rms );
-	  pd.SetPedRmsErr( (float)rms_err );
-
-	  fData.AddOrReplaceRow(pd);
-	}
-      }
+      //DBFolder was updated, so replace the Snapshot, patched from the current one where possible
+      fData = this->NextSnapshot(*fData, ReadRows<DetPedestal>);
     }
+    fCurrentTimeStamp.store(ts, std::memory_order_release);
 
     return result;
-
-  }
-
-  const DetPedestal& DetPedestalRetrievalAlg::Pedestal(DBChannelID_t ch) const {
-    DBUpdate();
-    return fData.GetRow(ch);
   }
 
   float DetPedestalRetrievalAlg::PedMean(DBChannelID_t ch) const {
@@ -223,6 +183,22 @@ namespace lariov {
     return this->Pedestal(ch).PedRmsErr();
   }
 
+  void DetPedestalRetrievalAlg::FillPedMean(DBChannelID_t const* channels, size_t n, float* values) const {
+    fData->FillField(SnapshotFields<DetPedestal>::kPedMean, channels, n, values);
+  }
+
+  void DetPedestalRetrievalAlg::FillPedRms(DBChannelID_t const* channels, size_t n, float* values) const {
+    fData->FillField(SnapshotFields<DetPedestal>::kPedRms, channels, n, values);
+  }
+
+  void DetPedestalRetrievalAlg::FillPedMeanErr(DBChannelID_t const* channels, size_t n, float* values) const {
+    fData->FillField(SnapshotFields<DetPedestal>::kPedMeanErr, channels, n, values);
+  }
+
+  void DetPedestalRetrievalAlg::FillPedRmsErr(DBChannelID_t const* channels, size_t n, float* values) const {
+    fData->FillField(SnapshotFields<DetPedestal>::kPedRmsErr, channels, n, values);
+  }
+
 
 
 }//end namespace lariov
@@ -15,15 +15,18 @@
 #define WEBDBI_DETPEDESTALRETRIEVALALG_H
 
 // C/C++ standard libraries
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 
 // LArSoft libraries
 #include "larevt/CalibrationDBI/IOVData/DetPedestal.h"
-#include "larevt/CalibrationDBI/IOVData/Snapshot.h"
 #include "larevt/CalibrationDBI/IOVData/IOVDataConstants.h"
 #include "larevt/CalibrationDBI/Interface/CalibrationDBIFwd.h"
 #include "larevt/CalibrationDBI/Interface/DetPedestalProvider.h"
 #include "larevt/CalibrationDBI/Providers/DatabaseRetrievalAlg.h"
+#include "larevt/CalibrationDBI/Providers/DBRowSchema.h"
 
 namespace fhicl { class ParameterSet; }
 
@@ -57,29 +60,52 @@ namespace lariov {
 
     public:
 
-      /// Constructors
+      /// Constructors; with usesqlite set, url names a local SQLite file
       DetPedestalRetrievalAlg(const std::string& foldername,
       			      const std::string& url,
-			      const std::string& tag="");
+			      const std::string& tag="",
+			      bool usesqlite=false);
 
       DetPedestalRetrievalAlg(fhicl::ParameterSet const& p);
 
       /// Reconfigure function called by fhicl constructor
       void Reconfigure(fhicl::ParameterSet const& p) override;
 
-      /// Update event time stamp.
+      /// Update event time stamp and bring the cached data up to date; same as Update()
       void UpdateTimeStamp(DBTimeStamp_t ts);
 
       /// Update Snapshot and inherited DBFolder if using database.  Return true if updated
       bool Update(DBTimeStamp_t ts);
 
+
+      /// Channels that changed at the last IOV switch; all of them may have if AllChannelsChanged()
+      const std::vector<unsigned int>& ChangedChannels() const { return fData->ChangedChannels(); }
+      bool AllChannelsChanged() const { return fData->AllChanged(); }
+
       /// Retrieve pedestal information
-      const DetPedestal& Pedestal(DBChannelID_t ch) const;
+      const DetPedestal& Pedestal(DBChannelID_t ch) const {
+        return fData->GetRow(ch);
+      }
+
+      /**
+        The data of all channels, for bulk use: Channels() and Field(SnapshotFields<DetPedestal>::...)
+        of the snapshot are contiguous arrays in channel order.  Take it once per event, after the update;
+        it stays valid until the next update.
+      */
+      const Snapshot<DetPedestal>& CurrentSnapshot() const {
+        return *fData;
+      }
       float PedMean(DBChannelID_t ch) const override;
       float PedRms(DBChannelID_t ch) const override;
       float PedMeanErr(DBChannelID_t ch) const override;
       float PedRmsErr(DBChannelID_t ch) const override;
 
+      /// Batch getters, read from the columns of the current snapshot
+      void FillPedMean(DBChannelID_t const* channels, size_t n, float* values) const override;
+      void FillPedRms(DBChannelID_t const* channels, size_t n, float* values) const override;
+      void FillPedMeanErr(DBChannelID_t const* channels, size_t n, float* values) const override;
+      void FillPedRmsErr(DBChannelID_t const* channels, size_t n, float* values) const override;
+
       //hardcoded information about database folder - useful for debugging cross checks
       static constexpr unsigned int NCOLUMNS = 5;
       static constexpr const char* FIELD_NAMES[NCOLUMNS]
@@ -91,16 +117,26 @@ namespace lariov {
 
       /// Do actual database updates.
 
-      bool DBUpdate() const;                    // Uses current event time.
-      bool DBUpdate(DBTimeStamp_t ts) const;
+      bool DBUpdate(DBTimeStamp_t ts);
 
       // Time stamps.
 
-      DBTimeStamp_t fEventTimeStamp;            // Most recently seen time stamp.
-      mutable DBTimeStamp_t fCurrentTimeStamp;  // Time stamp of cached data.
+      std::atomic<DBTimeStamp_t> fEventTimeStamp;           // Most recently seen time stamp.
+      std::atomic<DBTimeStamp_t> fCurrentTimeStamp;         // Time stamp of cached data.
+      std::mutex fUpdateMutex;                              // Serializes updates; not taken once data are current
+
+      std::unique_ptr<const Snapshot<DetPedestal>> fData;    // Replaced whole at each IOV
+  };
 
-      DataSource::ds fDataSource;
-      mutable Snapshot<DetPedestal> fData;
+  /// Database columns of a pedestal row
+  template <>
+  struct DBRowSchema<DetPedestal> {
+    static auto Columns() {
+      return std::make_tuple(MakeDBColumn<double>("mean",     &DetPedestal::SetPedMean),
+                             MakeDBColumn<double>("mean_err", &DetPedestal::SetPedMeanErr),
+                             MakeDBColumn<double>("rms",      &DetPedestal::SetPedRms),
+                             MakeDBColumn<double>("rms_err",  &DetPedestal::SetPedRmsErr));
+    }
   };
 }//end namespace lariov
 
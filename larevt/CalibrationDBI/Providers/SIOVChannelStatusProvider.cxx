@@ -55,28 +55,26 @@ namespace lariov {
 	  << "File "<<abs_fp<<" is not found.";
       }
 
-      std::string line;
-      ChannelStatus cs(0);
-      while (std::getline(file, line)) {
-        DBChannelID_t ch = (DBChannelID_t)std::stoi(line.substr(0, line.find(',')));
-	int status = std::stoi(line.substr(line.find(',')+1));
-
-	cs.SetChannel(ch);
-	cs.SetStatus( ChannelStatus::GetStatusFromInt(status) );
-	fData.AddOrReplaceRow(cs);
+      auto data = std::make_unique<Snapshot<ChannelStatus>>();
+
+      //binary snapshot with database column names, or text with one channel per line
+      if (DBDataset::IsBinaryFile(abs_fp)) {
+        ReadRows(*DBDataset::ReadFile(abs_fp), *data);
+      }
+      else {
+        ReadRows(*DBDataset::ReadCSVFile(abs_fp, {"channel", "status"}, {"bigint", "integer"}), *data);
       }
+      fData = std::move(data);
     } // if source from file
     else {
       std::cout << "Using channel statuses from conditions database\n";
     }
   }
 
-  // This method saves the time stamp of the latest event.
+  // This method saves the time stamp of the latest event and validates the cached data for it.
 
   void SIOVChannelStatusProvider::UpdateTimeStamp(DBTimeStamp_t ts) {
-    mf::LogInfo("SIOVChannelStatusProvider") << "SIOVChannelStatusProvider::UpdateTimeStamp called.";
-    fNewNoisy.Clear();
-    fEventTimeStamp = ts;
+    this->Update(ts);
   }
 
   // Maybe update method cached data (public non-const version).
@@ -84,66 +82,32 @@ namespace lariov {
   bool SIOVChannelStatusProvider::Update(DBTimeStamp_t ts) {
 
     fEventTimeStamp = ts;
-    fNewNoisy.Clear();
+    this->ClearNoisyChannels();
     return DBUpdate(ts);
   }
 
-  // Maybe update method cached data (private const version using current event time).
-
-  bool SIOVChannelStatusProvider::DBUpdate() const {
-    return DBUpdate(fEventTimeStamp);
-  }
-
-  // Maybe update method cached data (private const version).
+  // Maybe update method cached data (private version).
   // This is the function that does the actual work of updating data from database.
 
-  bool SIOVChannelStatusProvider::DBUpdate(DBTimeStamp_t ts) const {
-
-    bool result = false;
-    if(fDataSource == DataSource::Database && ts != fCurrentTimeStamp) {
+  bool SIOVChannelStatusProvider::DBUpdate(DBTimeStamp_t ts) {
 
-      mf::LogInfo("SIOVChannelStatusProvider") << "SIOVChannelStatusProvider::DBUpdate called with new timestamp.";
+    if (fDataSource != DataSource::Database || ts == fCurrentTimeStamp.load(std::memory_order_acquire)) return false;
 
-      fCurrentTimeStamp = ts;
+    //only one thread updates; the others wait here and find the data current
+    std::lock_guard<std::mutex> lock(fUpdateMutex);
+    if (ts == fCurrentTimeStamp.load(std::memory_order_relaxed)) return false;
 
-      // Call non-const base class method.
+    mf::LogInfo("SIOVChannelStatusProvider") << "SIOVChannelStatusProvider::DBUpdate called with new timestamp.";
 
-      result = const_cast<SIOVChannelStatusProvider*>(this)->UpdateFolder(ts);
-      if(result) {
-	//DBFolder was updated, so now update the Snapshot
-	fData.Clear();
-	fData.SetIoV(this->Begin(), this->End());
+    bool result = fFolder->UpdateData(ts);
+    if (result) {
 
-	std::vector<DBChannelID_t> channels;
-	fFolder->GetChannelList(channels);
-	for (auto it = channels.begin(); it != channels.end(); ++it) {
-
-	  long status;
-	  fFolder->GetNamedChannelData(*it, "status", status);
-
-	  ChannelStatus cs(*it);
-	  cs.SetStatus( ChannelStatus::GetStatusFromInt((int)status) );
-
-	  fData.AddOrReplaceRow(cs);
-	}
-      }
+      //DBFolder was updated, so replace the Snapshot, patched from the current one where possible
+      fData = this->NextSnapshot(*fData, ReadRows<ChannelStatus>);
     }
-    return result;
-  }
-
+    fCurrentTimeStamp.store(ts, std::memory_order_release);
 
-  //----------------------------------------------------------------------------
-  const ChannelStatus& SIOVChannelStatusProvider::GetChannelStatus(raw::ChannelID_t ch) const {
-    if (fDataSource == DataSource::Default) {
-      return fDefault;
-    }
-    DBUpdate();
-    if (fNewNoisy.HasChannel(rawToDBChannel(ch))) {
-      return fNewNoisy.GetRow(rawToDBChannel(ch));
-    }
-    else {
-      return fData.GetRow(rawToDBChannel(ch));
-    }
+    return result;
   }
 
 
@@ -213,6 +177,12 @@ namespace lariov {
   }
 
 
+  //----------------------------------------------------------------------------
+  void SIOVChannelStatusProvider::ClearNoisyChannels() {
+    if (fNewNoisy.NChannels() != 0) fNewNoisy.Clear();
+  }
+
+
 
   //----------------------------------------------------------------------------
 
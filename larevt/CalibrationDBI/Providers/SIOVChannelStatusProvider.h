@@ -10,12 +10,17 @@
 #ifndef SIOVCHANNELSTATUSPROVIDER_H
 #define SIOVCHANNELSTATUSPROVIDER_H 1
 
+// C/C++ standard libraries
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 // LArSoft libraries
 #include "larcoreobj/SimpleTypesAndConstants/RawTypes.h"
 #include "larevt/CalibrationDBI/Interface/ChannelStatusProvider.h"
 #include "larevt/CalibrationDBI/Providers/DatabaseRetrievalAlg.h"
+#include "larevt/CalibrationDBI/Providers/DBRowSchema.h"
 #include "larevt/CalibrationDBI/IOVData/ChannelStatus.h"
-#include "larevt/CalibrationDBI/IOVData/Snapshot.h"
 #include "larevt/CalibrationDBI/IOVData/IOVDataConstants.h"
 #include "larevt/CalibrationDBI/Interface/CalibrationDBIFwd.h"
 
@@ -47,8 +52,13 @@ namespace lariov {
       //
       // non-interface methods
       //
-      /// Returns Channel Status
-      const ChannelStatus& GetChannelStatus(raw::ChannelID_t channel) const;
+      /// Returns Channel Status; the data are brought up to date once per event by Update()
+      const ChannelStatus& GetChannelStatus(raw::ChannelID_t channel) const {
+        if (fDataSource == DataSource::Default) return fDefault;
+        const DBChannelID_t ch = rawToDBChannel(channel);
+        if (fNewNoisy.NChannels() != 0 && fNewNoisy.HasChannel(ch)) return fNewNoisy.GetRow(ch);
+        return fData->GetRow(ch);
+      }
 
       //
       // interface methods
@@ -94,7 +104,7 @@ namespace lariov {
       /// @}
 
 
-      /// Update event time stamp.
+      /// Update event time stamp and bring the cached data up to date; same as Update()
       void UpdateTimeStamp(DBTimeStamp_t ts);
 
       /// @name Configuration functions
@@ -102,9 +112,17 @@ namespace lariov {
       /// Prepares the object to provide information about the specified time
       bool Update(DBTimeStamp_t);
 
+
+      /// Channels that changed at the last IOV switch; all of them may have if AllChannelsChanged()
+      const std::vector<unsigned int>& ChangedChannels() const { return fData->ChangedChannels(); }
+      bool AllChannelsChanged() const { return fData->AllChanged(); }
+
       /// Allows a service to add to the list of noisy channels
       void AddNoisyChannel(raw::ChannelID_t ch);
 
+      /// Drop the channels added by AddNoisyChannel; they only hold for one event
+      void ClearNoisyChannels();
+
       ///@}
 
 
@@ -116,23 +134,32 @@ namespace lariov {
 
       /// Do actual database updates.
 
-      bool DBUpdate() const;                    // Uses current event time.
-      bool DBUpdate(DBTimeStamp_t ts) const;
+      bool DBUpdate(DBTimeStamp_t ts);
 
       // Time stamps.
 
-      DBTimeStamp_t fEventTimeStamp;            // Most recently seen time stamp.
-      mutable DBTimeStamp_t fCurrentTimeStamp;  // Time stamp of cached data.
+      std::atomic<DBTimeStamp_t> fEventTimeStamp;           // Most recently seen time stamp.
+      std::atomic<DBTimeStamp_t> fCurrentTimeStamp;         // Time stamp of cached data.
+      std::mutex fUpdateMutex;                              // Serializes updates; not taken once data are current
 
-      DataSource::ds fDataSource;
-      mutable Snapshot<ChannelStatus> fData;    // Lazily updated once per IOV.
-      Snapshot<ChannelStatus> fNewNoisy;        // Updated once per event.
+      std::unique_ptr<const Snapshot<ChannelStatus>> fData;    // Replaced whole at each IOV
+      Snapshot<ChannelStatus> fNewNoisy;      // Noisy channels of the current event only
       ChannelStatus fDefault;
 
       ChannelSet_t GetChannelsWithStatus(chStatus status) const;
 
   }; // class SIOVChannelStatusProvider
 
+  /// Database columns of a channel status row
+  template <>
+  struct DBRowSchema<ChannelStatus> {
+    static auto Columns() {
+      return std::make_tuple(MakeDBColumn<long>("status", [](ChannelStatus& cs, long status) {
+                               cs.SetStatus(ChannelStatus::GetStatusFromInt((int)status));
+                             }));
+    }
+  };
+
 
 } // namespace lariov
 
@@ -21,10 +21,11 @@ namespace lariov {
   void SIOVElectronicsCalibProvider::Reconfigure(fhicl::ParameterSet const& p) {
 
     this->DatabaseRetrievalAlg::Reconfigure(p.get<fhicl::ParameterSet>("DatabaseRetrievalAlg"));
-    fData.Clear();
+    auto data = std::make_unique<Snapshot<ElectronicsCalib>>();
+    data->Clear();
     IOVTimeStamp tmp = IOVTimeStamp::MaxTimeStamp();
     tmp.SetStamp(tmp.Stamp()-1, tmp.SubStamp());
-    fData.SetIoV(tmp, IOVTimeStamp::MaxTimeStamp());
+    data->SetIoV(tmp, IOVTimeStamp::MaxTimeStamp());
 
     bool UseDB      = p.get<bool>("UseDB", false);
     bool UseFile    = p.get<bool>("UseFile", false);
@@ -55,7 +56,7 @@ namespace lariov {
       for (; itW != geo->end_wire_id(); ++itW) {
 	DBChannelID_t ch = geo->PlaneWireToChannel(*itW);
 	defaultCalib.SetChannel(ch);
-	fData.AddOrReplaceRow(defaultCalib);
+	data->AddOrReplaceRow(defaultCalib);
       }
 
     }
@@ -69,44 +70,27 @@ namespace lariov {
           << "File "<<abs_fp<<" is not found.";
       }
 
-      std::string line;
-      ElectronicsCalib dp(0);
-      while (std::getline(file, line)) {
-        size_t current_comma = line.find(',');
-        DBChannelID_t ch = (DBChannelID_t)std::stoi(line.substr(0, current_comma));
-        float gain             = std::stof( line.substr(current_comma+1, line.find(',',current_comma+1)-(current_comma+1)) );
-
-        current_comma = line.find(',',current_comma+1);
-        float gain_err         = std::stof( line.substr(current_comma+1, line.find(',',current_comma+1)-(current_comma+1)) );
-
-	current_comma = line.find(',',current_comma+1);
-        float shaping_time     = std::stof( line.substr(current_comma+1, line.find(',',current_comma+1)-(current_comma+1)) );
-
-	current_comma = line.find(',',current_comma+1);
-        float shaping_time_err = std::stof( line.substr(current_comma+1) );
-
-        CalibrationExtraInfo info("ElectronicsCalib");
-
-        dp.SetChannel(ch);
-        dp.SetGain(gain);
-        dp.SetGainErr(gain_err);
-	dp.SetShapingTime(shaping_time);
-        dp.SetShapingTimeErr(shaping_time_err);
-	dp.SetExtraInfo(info);
-
-        fData.AddOrReplaceRow(dp);
+      //binary snapshot with database column names, or text with one channel per line
+      if (DBDataset::IsBinaryFile(abs_fp)) {
+        ReadRows(*DBDataset::ReadFile(abs_fp), *data);
+      }
+      else {
+        ReadRows(*DBDataset::ReadCSVFile(abs_fp,
+                                         {"channel", "gain", "gain_err", "shaping_time", "shaping_time_err"},
+                                         {"bigint", "real", "real", "real", "real"}), *data);
       }
     }
     else {
       std::cout << "Using electronics calibrations from conditions database"<<std::endl;
     }
+
+    fData = std::move(data);
   }
 
-  // This method saves the time stamp of the latest event.
+  // This method saves the time stamp of the latest event and validates the cached data for it.
 
   void SIOVElectronicsCalibProvider::UpdateTimeStamp(DBTimeStamp_t ts) {
-    mf::LogInfo("SIOVElectronicsCalibProvider") << "SIOVElectronicsCalibProvider::UpdateTimeStamp called.";
-    fEventTimeStamp = ts;
+    this->Update(ts);
   }
 
   // Maybe update method cached data (public non-const version).
@@ -117,63 +101,30 @@ namespace lariov {
     return DBUpdate(ts);
   }
 
-  // Maybe update method cached data (private const version using current event time).
-
-  bool SIOVElectronicsCalibProvider::DBUpdate() const {
-    return DBUpdate(fEventTimeStamp);
-  }
-
-  // Maybe update method cached data (private const version).
+  // Maybe update method cached data (private version).
   // This is the function that does the actual work of updating data from database.
 
-  bool SIOVElectronicsCalibProvider::DBUpdate(DBTimeStamp_t ts) const {
-
-    bool result = false;
-    if (fDataSource == DataSource::Database && ts != fCurrentTimeStamp) {
-
-      mf::LogInfo("SIOVElectronicsCalibProvider") << "SIOVElectronicsCalibProvider::DBUpdate called with new timestamp.";
+  bool SIOVElectronicsCalibProvider::DBUpdate(DBTimeStamp_t ts) {
 
-      fCurrentTimeStamp = ts;
+    if (fDataSource != DataSource::Database || ts == fCurrentTimeStamp.load(std::memory_order_acquire)) return false;
 
-      // Call non-const base class method.
+    //only one thread updates; the others wait here and find the data current
+    std::lock_guard<std::mutex> lock(fUpdateMutex);
+    if (ts == fCurrentTimeStamp.load(std::memory_order_relaxed)) return false;
 
-      result = const_cast<SIOVElectronicsCalibProvider*>(this)->UpdateFolder(ts);
-      if(result) {
-	//DBFolder was updated, so now update the Snapshot
-	fData.Clear();
-	fData.SetIoV(this->Begin(), this->End());
+    mf::LogInfo("SIOVElectronicsCalibProvider") << "SIOVElectronicsCalibProvider::DBUpdate called with new timestamp.";
 
-	std::vector<DBChannelID_t> channels;
-	fFolder->GetChannelList(channels);
-	for (auto it = channels.begin(); it != channels.end(); ++it) {
+    bool result = fFolder->UpdateData(ts);
+    if (result) {
 
-	  double gain, gain_err, shaping_time, shaping_time_err;
-	  fFolder->GetNamedChannelData(*it, "gain",     gain);
-	  fFolder->GetNamedChannelData(*it, "gain_err", gain_err);
-	  fFolder->GetNamedChannelData(*it, "shaping_time",     shaping_time);
-	  fFolder->GetNamedChannelData(*it, "shaping_time_err", shaping_time_err);
-
-
-	  ElectronicsCalib pg(*it);
-	  pg.SetGain( (float)gain );
-	  pg.SetGainErr( (float)gain_err );
-	  pg.SetShapingTime( (float)shaping_time );
-	  pg.SetShapingTimeErr( (float)shaping_time_err );
-	  pg.SetExtraInfo(CalibrationExtraInfo("ElectronicsCalib"));
-
-	  fData.AddOrReplaceRow(pg);
-	}
-      }
+      //DBFolder was updated, so replace the Snapshot, patched from the current one where possible
+      fData = this->NextSnapshot(*fData, ReadRows<ElectronicsCalib>);
     }
+    fCurrentTimeStamp.store(ts, std::memory_order_release);
 
     return result;
   }
 
-  const ElectronicsCalib& SIOVElectronicsCalibProvider::ElectronicsCalibObject(DBChannelID_t ch) const {
-    DBUpdate();
-    return fData.GetRow(ch);
-  }
-
   float SIOVElectronicsCalibProvider::Gain(DBChannelID_t ch) const {
     return this->ElectronicsCalibObject(ch).Gain();
   }
@@ -190,6 +141,22 @@ namespace lariov {
     return this->ElectronicsCalibObject(ch).ShapingTimeErr();
   }
 
+  void SIOVElectronicsCalibProvider::FillGain(DBChannelID_t const* channels, size_t n, float* values) const {
+    fData->FillField(SnapshotFields<ElectronicsCalib>::kGain, channels, n, values);
+  }
+
+  void SIOVElectronicsCalibProvider::FillGainErr(DBChannelID_t const* channels, size_t n, float* values) const {
+    fData->FillField(SnapshotFields<ElectronicsCalib>::kGainErr, channels, n, values);
+  }
+
+  void SIOVElectronicsCalibProvider::FillShapingTime(DBChannelID_t const* channels, size_t n, float* values) const {
+    fData->FillField(SnapshotFields<ElectronicsCalib>::kShapingTime, channels, n, values);
+  }
+
+  void SIOVElectronicsCalibProvider::FillShapingTimeErr(DBChannelID_t const* channels, size_t n, float* values) const {
+    fData->FillField(SnapshotFields<ElectronicsCalib>::kShapingTimeErr, channels, n, values);
+  }
+
   CalibrationExtraInfo const& SIOVElectronicsCalibProvider::ExtraInfo(DBChannelID_t ch) const {
     return this->ElectronicsCalibObject(ch).ExtraInfo();
   }
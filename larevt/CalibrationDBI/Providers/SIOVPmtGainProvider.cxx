@@ -21,10 +21,11 @@ namespace lariov {
   void SIOVPmtGainProvider::Reconfigure(fhicl::ParameterSet const& p) {
 
     this->DatabaseRetrievalAlg::Reconfigure(p.get<fhicl::ParameterSet>("DatabaseRetrievalAlg"));
-    fData.Clear();
+    auto data = std::make_unique<Snapshot<PmtGain>>();
+    data->Clear();
     IOVTimeStamp tmp = IOVTimeStamp::MaxTimeStamp();
     tmp.SetStamp(tmp.Stamp()-1, tmp.SubStamp());
-    fData.SetIoV(tmp, IOVTimeStamp::MaxTimeStamp());
+    data->SetIoV(tmp, IOVTimeStamp::MaxTimeStamp());
 
     bool UseDB      = p.get<bool>("UseDB", false);
     bool UseFile    = p.get<bool>("UseFile", false);
@@ -50,7 +51,7 @@ namespace lariov {
       for (unsigned int od=0; od!=geo->NOpDets(); ++od) {
         if (geo->IsValidOpChannel(od)) {
 	  defaultGain.SetChannel(od);
-	  fData.AddOrReplaceRow(defaultGain);
+	  data->AddOrReplaceRow(defaultGain);
 	}
       }
 
@@ -65,37 +66,27 @@ namespace lariov {
           << "File "<<abs_fp<<" is not found.";
       }
 
-      std::string line;
-      PmtGain dp(0);
-      while (std::getline(file, line)) {
-        if (line[0] == '#') continue;
-        size_t current_comma = line.find(',');
-        DBChannelID_t ch = (DBChannelID_t)std::stoi(line.substr(0, current_comma));
-        float gain     = std::stof( line.substr(current_comma+1, line.find(',',current_comma+1)-(current_comma+1)) );
-
-        current_comma = line.find(',',current_comma+1);
-        float gain_err = std::stof( line.substr(current_comma+1) );
-
-        CalibrationExtraInfo info("PmtGain");
-
-        dp.SetChannel(ch);
-        dp.SetGain(gain);
-        dp.SetGainErr(gain_err);
-	dp.SetExtraInfo(info);
-
-        fData.AddOrReplaceRow(dp);
+      //binary snapshot with database column names, or text with one channel per line
+      if (DBDataset::IsBinaryFile(abs_fp)) {
+        ReadRows(*DBDataset::ReadFile(abs_fp), *data);
+      }
+      else {
+        ReadRows(*DBDataset::ReadCSVFile(abs_fp,
+                                         {"channel", "gain", "gain_sigma"},
+                                         {"bigint", "real", "real"}), *data);
       }
     }
     else {
       std::cout << "Using pmt gains from conditions database"<<std::endl;
     }
+
+    fData = std::move(data);
   }
 
-  // This method saves the time stamp of the latest event.
+  // This method saves the time stamp of the latest event and validates the cached data for it.
 
   void SIOVPmtGainProvider::UpdateTimeStamp(DBTimeStamp_t ts) {
-    mf::LogInfo("SIOVPmtGainProvider") << "SIOVPmtGainProvider::UpdateTimeStamp called.";
-    fEventTimeStamp = ts;
+    this->Update(ts);
   }
 
   // Maybe update method cached data (public non-const version).
@@ -106,58 +97,30 @@ namespace lariov {
     return DBUpdate(ts);
   }
 
-  // Maybe update method cached data (private const version using current event time).
-
-  bool SIOVPmtGainProvider::DBUpdate() const {
-    return DBUpdate(fEventTimeStamp);
-  }
-
-  // Maybe update method cached data (private const version).
+  // Maybe update method cached data (private version).
   // This is the function that does the actual work of updating data from database.
 
-  bool SIOVPmtGainProvider::DBUpdate(DBTimeStamp_t ts) const {
-
-    bool result = false;
-    if (fDataSource == DataSource::Database && ts != fCurrentTimeStamp) {
+  bool SIOVPmtGainProvider::DBUpdate(DBTimeStamp_t ts) {
 
-      mf::LogInfo("SIOVPmtGainProvider") << "SIOVPmtGainProvider::DBUpdate called with new timestamp.";
+    if (fDataSource != DataSource::Database || ts == fCurrentTimeStamp.load(std::memory_order_acquire)) return false;
 
-      fCurrentTimeStamp = ts;
+    //only one thread updates; the others wait here and find the data current
+    std::lock_guard<std::mutex> lock(fUpdateMutex);
+    if (ts == fCurrentTimeStamp.load(std::memory_order_relaxed)) return false;
 
-      // Call non-const base class method.
+    mf::LogInfo("SIOVPmtGainProvider") << "SIOVPmtGainProvider::DBUpdate called with new timestamp.";
 
-      result = const_cast<SIOVPmtGainProvider*>(this)->UpdateFolder(ts);
-      if(result) {
-	//DBFolder was updated, so now update the Snapshot
-	fData.Clear();
-	fData.SetIoV(this->Begin(), this->End());
+    bool result = fFolder->UpdateData(ts);
+    if (result) {
 
-	std::vector<DBChannelID_t> channels;
-	fFolder->GetChannelList(channels);
-	for (auto it = channels.begin(); it != channels.end(); ++it) {
-
-	  double gain, gain_err;
-	  fFolder->GetNamedChannelData(*it, "gain",     gain);
-	  fFolder->GetNamedChannelData(*it, "gain_sigma", gain_err);
-
-	  PmtGain pg(*it);
-	  pg.SetGain( (float)gain );
-	  pg.SetGainErr( (float)gain_err );
-	  pg.SetExtraInfo(CalibrationExtraInfo("PmtGain"));
-
-	  fData.AddOrReplaceRow(pg);
-	}
-      }
+      //DBFolder was updated, so replace the Snapshot, patched from the current one where possible
+      fData = this->NextSnapshot(*fData, ReadRows<PmtGain>);
     }
+    fCurrentTimeStamp.store(ts, std::memory_order_release);
 
     return result;
   }
 
-  const PmtGain& SIOVPmtGainProvider::PmtGainObject(DBChannelID_t ch) const {
-    DBUpdate();
-    return fData.GetRow(ch);
-  }
-
   float SIOVPmtGainProvider::Gain(DBChannelID_t ch) const {
     return this->PmtGainObject(ch).Gain();
   }
@@ -166,6 +129,14 @@ namespace lariov {
     return this->PmtGainObject(ch).GainErr();
   }
 
+  void SIOVPmtGainProvider::FillGain(DBChannelID_t const* channels, size_t n, float* values) const {
+    fData->FillField(SnapshotFields<PmtGain>::kGain, channels, n, values);
+  }
+
+  void SIOVPmtGainProvider::FillGainErr(DBChannelID_t const* channels, size_t n, float* values) const {
+    fData->FillField(SnapshotFields<PmtGain>::kGainErr, channels, n, values);
+  }
+
   CalibrationExtraInfo const& SIOVPmtGainProvider::ExtraInfo(DBChannelID_t ch) const {
     return this->PmtGainObject(ch).ExtraInfo();
   }
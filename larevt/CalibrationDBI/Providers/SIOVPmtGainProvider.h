@@ -12,10 +12,13 @@
 #define SIOVPMTGAINPROVIDER_H
 
 #include "larevt/CalibrationDBI/IOVData/PmtGain.h"
-#include "larevt/CalibrationDBI/IOVData/Snapshot.h"
 #include "larevt/CalibrationDBI/IOVData/IOVDataConstants.h"
 #include "larevt/CalibrationDBI/Interface/PmtGainProvider.h"
 #include "DatabaseRetrievalAlg.h"
+#include "DBRowSchema.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace lariov {
 
@@ -45,33 +48,60 @@ namespace lariov {
       /// Reconfigure function called by fhicl constructor
       void Reconfigure(fhicl::ParameterSet const& p) override;
 
-      /// Update event time stamp.
+      /// Update event time stamp and bring the cached data up to date; same as Update()
       void UpdateTimeStamp(DBTimeStamp_t ts);
 
       /// Update Snapshot and inherited DBFolder if using database.  Return true if updated
       bool Update(DBTimeStamp_t ts);
 
+
+      /// Channels that changed at the last IOV switch; all of them may have if AllChannelsChanged()
+      const std::vector<unsigned int>& ChangedChannels() const { return fData->ChangedChannels(); }
+      bool AllChannelsChanged() const { return fData->AllChanged(); }
+
       /// Retrieve gain information
-      const PmtGain& PmtGainObject(DBChannelID_t ch) const;
+      const PmtGain& PmtGainObject(DBChannelID_t ch) const {
+        return fData->GetRow(ch);
+      }
+
+      /**
+        The data of all channels, for bulk use: Channels() and Field(SnapshotFields<PmtGain>::...)
+        of the snapshot are contiguous arrays in channel order.  Take it once per event, after the update;
+        it stays valid until the next update.
+      */
+      const Snapshot<PmtGain>& CurrentSnapshot() const {
+        return *fData;
+      }
       float Gain(DBChannelID_t ch) const override;
       float GainErr(DBChannelID_t ch) const override;
+
+      /// Batch getters, read from the columns of the current snapshot
+      void FillGain(DBChannelID_t const* channels, size_t n, float* values) const override;
+      void FillGainErr(DBChannelID_t const* channels, size_t n, float* values) const override;
       CalibrationExtraInfo const& ExtraInfo(DBChannelID_t ch) const override;
 
     private:
 
       /// Do actual database updates.
 
-      bool DBUpdate() const;                    // Uses current event time.
-      bool DBUpdate(DBTimeStamp_t ts) const;
+      bool DBUpdate(DBTimeStamp_t ts);
 
       // Time stamps.
 
-      DBTimeStamp_t fEventTimeStamp;            // Most recently seen time stamp.
-      mutable DBTimeStamp_t fCurrentTimeStamp;  // Time stamp of cached data.
+      std::atomic<DBTimeStamp_t> fEventTimeStamp;           // Most recently seen time stamp.
+      std::atomic<DBTimeStamp_t> fCurrentTimeStamp;         // Time stamp of cached data.
+      std::mutex fUpdateMutex;                              // Serializes updates; not taken once data are current
 
-      DataSource::ds fDataSource;
+      std::unique_ptr<const Snapshot<PmtGain>> fData;    // Replaced whole at each IOV
+  };
 
-      mutable Snapshot<PmtGain> fData;
+  /// Database columns of a PMT gain row
+  template <>
+  struct DBRowSchema<PmtGain> {
+    static auto Columns() {
+      return std::make_tuple(MakeDBColumn<double>("gain",       &PmtGain::SetGain),
+                             MakeDBColumn<double>("gain_sigma", &PmtGain::SetGainErr));
+    }
   };
 }//end namespace lariov
 
@@ -21,12 +21,13 @@ namespace lariov {
 
   /**
      \class WebError
+     Transient errors (no answer, an overloaded or failing server) may go away if the request is repeated later.
   */
   class WebError : public std::exception{
 
   public:
 
-    WebError(std::string msg="") : std::exception()
+    WebError(std::string msg="", bool transient=false) : std::exception(), _transient(transient)
     {
       _msg = "\033[93m";
       _msg += msg;
@@ -37,8 +38,11 @@ namespace lariov {
     virtual const char* what() const throw()
     { return _msg.c_str(); }
 
+    bool Transient() const { return _transient; }
+
   private:
     std::string _msg;
+    bool _transient;
   };
 
 }
@@ -0,0 +1,49 @@
+/**
+ * @file   ConditionsClockService.h
+ * @brief  Service keeping all conditions folders current with the event time
+ */
+
+#ifndef CONDITIONSCLOCKSERVICE_H
+#define CONDITIONSCLOCKSERVICE_H
+
+// Framework libraries
+#include "art/Framework/Services/Registry/ServiceMacros.h"
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/Providers/ConditionsClock.h"
+
+namespace art {
+  class ActivityRegistry;
+  class Event;
+  class ScheduleContext;
+}
+namespace fhicl { class ParameterSet; }
+
+namespace lariov {
+
+  /**
+   \class ConditionsClockService
+   Decodes the event time once per event and updates the conditions folders
+   that reach the end of their IOV, in parallel.  The SIOV calibration
+   services watch their folder through this service when it is configured,
+   and check their own folder at each event otherwise.
+   */
+  class ConditionsClockService {
+
+    public:
+
+      ConditionsClockService(fhicl::ParameterSet const& pset, art::ActivityRegistry& reg);
+
+      ConditionsClock& Clock() { return fClock; }
+
+      void PreProcessEvent(const art::Event& evt, art::ScheduleContext);
+
+    private:
+
+      ConditionsClock fClock;
+  };
+}//end namespace lariov
+
+DECLARE_ART_SERVICE(lariov::ConditionsClockService, SHARED)
+
+#endif
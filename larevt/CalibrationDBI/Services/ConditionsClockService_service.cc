@@ -0,0 +1,21 @@
+#include "larevt/CalibrationDBI/Services/ConditionsClockService.h"
+#include "art/Framework/Services/Registry/ActivityRegistry.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Persistency/Provenance/ScheduleContext.h"
+#include "fhiclcpp/ParameterSet.h"
+
+namespace lariov{
+
+  ConditionsClockService::ConditionsClockService(fhicl::ParameterSet const&, art::ActivityRegistry& reg)
+  {
+    //the one callback checking the conditions folders before each event is processed
+    reg.sPreProcessEvent.watch(this, &ConditionsClockService::PreProcessEvent);
+  }
+
+  void ConditionsClockService::PreProcessEvent(const art::Event& evt, art::ScheduleContext) {
+    fClock.Tick(evt.time().value());
+  }
+
+}//end namespace lariov
+
+DEFINE_ART_SERVICE(lariov::ConditionsClockService)
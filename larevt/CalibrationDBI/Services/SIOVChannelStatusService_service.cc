@@ -1,10 +1,15 @@
 #include "art/Framework/Services/Registry/ServiceMacros.h"
 #include "art/Framework/Services/Registry/ActivityRegistry.h"
+#include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "art/Framework/Services/Registry/ServiceRegistry.h"
 #include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+#include "art/Framework/Principal/SubRun.h"
 #include "art/Persistency/Provenance/ScheduleContext.h"
 #include "fhiclcpp/ParameterSet.h"
 #include "larevt/CalibrationDBI/Interface/ChannelStatusService.h"
 #include "larevt/CalibrationDBI/Providers/SIOVChannelStatusProvider.h"
+#include "larevt/CalibrationDBI/Services/ConditionsClockService.h"
 
 namespace lariov{
 
@@ -22,6 +27,14 @@ namespace lariov{
 
       void PreProcessEvent(const art::Event& evt, art::ScheduleContext);
 
+      void PreBeginRun(const art::Run& run) {
+        if (fProvider.UsesDatabase()) fProvider.PreloadForRun(run.beginTime().value(), run.endTime().value());
+      }
+
+      void PostBeginSubRun(const art::SubRun&) {
+        fProvider.PrefetchFolder();
+      }
+
     private:
 
       const ChannelStatusProvider& DoGetProvider() const override {
@@ -46,15 +59,28 @@ namespace lariov{
   {
 
     //register callback to update local database cache before each event is processed
-    reg.sPreProcessEvent.watch(this, &SIOVChannelStatusService::PreProcessEvent);
+    if (art::ServiceRegistry::isAvailable<ConditionsClockService>()) {
+      ConditionsClock& clock = art::ServiceHandle<ConditionsClockService>()->Clock();
+      clock.WatchEvents([this](DBTimeStamp_t) { fProvider.ClearNoisyChannels(); });
+      if (fProvider.UsesDatabase()) {
+        clock.Watch(fProvider.FolderName(),
+                    [this](const IOVTimeStamp& ts) { return fProvider.IsCurrent(ts); },
+                    [this](DBTimeStamp_t ts) { fProvider.Update(ts); },
+                    [this](const IOVTimeStamp& ts) { fProvider.MaybePrefetch(ts); });
+      }
+    }
+    else {
+      reg.sPreProcessEvent.watch(this, &SIOVChannelStatusService::PreProcessEvent);
+    }
 
+    reg.sPreBeginRun.watch(this, &SIOVChannelStatusService::PreBeginRun);
+    reg.sPostBeginSubRun.watch(this, &SIOVChannelStatusService::PostBeginSubRun);
   }
 
 
   void SIOVChannelStatusService::PreProcessEvent(const art::Event& evt, art::ScheduleContext) {
 
-    //First grab an update from the database
-    fProvider.UpdateTimeStamp(evt.time().value());
+    fProvider.Update(evt.time().value());
   }
 
 }//end namespace lariov
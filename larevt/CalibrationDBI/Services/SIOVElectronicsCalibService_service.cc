@@ -1,10 +1,15 @@
 #include "art/Framework/Services/Registry/ServiceMacros.h"
 #include "art/Framework/Services/Registry/ActivityRegistry.h"
+#include "art/Framework/Services/Registry/ServiceHandle.h"
+#include "art/Framework/Services/Registry/ServiceRegistry.h"
 #include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+#include "art/Framework/Principal/SubRun.h"
 #include "art/Persistency/Provenance/ScheduleContext.h"
 #include "fhiclcpp/ParameterSet.h"
 #include "larevt/CalibrationDBI/Interface/ElectronicsCalibService.h"
 #include "larevt/CalibrationDBI/Providers/SIOVElectronicsCalibProvider.h"
+#include "larevt/CalibrationDBI/Services/ConditionsClockService.h"
 
 namespace lariov{
 
@@ -22,7 +27,15 @@ namespace lariov{
       ~SIOVElectronicsCalibService(){}
 
       void PreProcessEvent(const art::Event& evt, art::ScheduleContext) {
-        fProvider.UpdateTimeStamp(evt.time().value());
+        fProvider.Update(evt.time().value());
+      }
+
+      void PreBeginRun(const art::Run& run) {
+        if (fProvider.UsesDatabase()) fProvider.PreloadForRun(run.beginTime().value(), run.endTime().value());
+      }
+
+      void PostBeginSubRun(const art::SubRun&) {
+        fProvider.PrefetchFolder();
       }
 
     private:
@@ -48,7 +61,21 @@ namespace lariov{
   : fProvider(pset.get<fhicl::ParameterSet>("ElectronicsCalibProvider"))
   {
     //register callback to update local database cache before each event is processed
-    reg.sPreProcessEvent.watch(this, &SIOVElectronicsCalibService::PreProcessEvent);
+    if (art::ServiceRegistry::isAvailable<ConditionsClockService>()) {
+      ConditionsClock& clock = art::ServiceHandle<ConditionsClockService>()->Clock();
+      if (fProvider.UsesDatabase()) {
+        clock.Watch(fProvider.FolderName(),
+                    [this](const IOVTimeStamp& ts) { return fProvider.IsCurrent(ts); },
+                    [this](DBTimeStamp_t ts) { fProvider.Update(ts); },
+                    [this](const IOVTimeStamp& ts) { fProvider.MaybePrefetch(ts); });
+      }
+    }
+    else {
+      reg.sPreProcessEvent.watch(this, &SIOVElectronicsCalibService::PreProcessEvent);
+    }
+
+    reg.sPreBeginRun.watch(this, &SIOVElectronicsCalibService::PreBeginRun);
+    reg.sPostBeginSubRun.watch(this, &SIOVElectronicsCalibService::PostBeginSubRun);
   }
 
 }//end namespace lariov
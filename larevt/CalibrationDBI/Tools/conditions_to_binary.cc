@@ -0,0 +1,89 @@
+/**
+ * @file   conditions_to_binary.cc
+ * @brief  Converts conditions payloads into the binary snapshot format
+ *
+ * Usage: conditions_to_binary csv <pedestal|channelstatus|pmtgain|electronicscalib> <input csv> <output file>
+ *        conditions_to_binary db <url> <folder> <time> <output file> [tag]
+ *
+ * The first form converts a local CSV file, as read by the providers with
+ * DataSource set to File, keeping its column order.  The second saves the
+ * payload valid at the given time from the web server.  Either output file can
+ * be given to the providers in place of the CSV file and is memory-mapped
+ * instead of parsed.
+ */
+
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+#include "larevt/CalibrationDBI/Providers/DBFolder.h"
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+  /// Database column names and types of each CSV layout, channel first
+  bool CSVSchema(const std::string& kind, std::vector<std::string>& names, std::vector<std::string>& types) {
+    if (kind == "pedestal") {
+      names = {"channel", "mean", "rms", "mean_err", "rms_err"};
+      types = {"bigint", "real", "real", "real", "real"};
+    }
+    else if (kind == "channelstatus") {
+      names = {"channel", "status"};
+      types = {"bigint", "integer"};
+    }
+    else if (kind == "pmtgain") {
+      names = {"channel", "gain", "gain_sigma"};
+      types = {"bigint", "real", "real"};
+    }
+    else if (kind == "electronicscalib") {
+      names = {"channel", "gain", "gain_err", "shaping_time", "shaping_time_err"};
+      types = {"bigint", "real", "real", "real", "real"};
+    }
+    else return false;
+    return true;
+  }
+
+  void Usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " csv <pedestal|channelstatus|pmtgain|electronicscalib> <input csv> <output file>\n"
+              << "       " << prog << " db <url> <folder> <time> <output file> [tag]" << std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+
+  const std::string mode = (argc > 1) ? argv[1] : "";
+
+  try {
+    if (mode == "csv" && argc == 5) {
+      std::vector<std::string> names, types;
+      if (!CSVSchema(argv[2], names, types)) {
+        Usage(argv[0]);
+        return 1;
+      }
+
+      auto data = lariov::DBDataset::ReadCSVFile(argv[3], names, types);
+      data->WriteFile(argv[4]);
+      std::cout << "Wrote " << data->NRows() << " channels to " << argv[4] << std::endl;
+    }
+    else if (mode == "db" && (argc == 6 || argc == 7)) {
+      const std::string tag = (argc > 6) ? argv[6] : "";
+      lariov::DBFolder source(argv[3], argv[2], tag);
+      auto data = source.FetchDataset(lariov::IOVTimeStamp::GetFromString(argv[4]));
+      data->WriteFile(argv[5]);
+      std::cout << "Wrote IOV " << data->Begin().DBStamp() << ", " << data->NRows()
+                << " channels of folder " << argv[3] << " to " << argv[5] << std::endl;
+    }
+    else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+  catch (std::exception const& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
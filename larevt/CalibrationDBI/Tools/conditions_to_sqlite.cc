@@ -0,0 +1,60 @@
+/**
+ * @file   conditions_to_sqlite.cc
+ * @brief  Dumps the history of a conditions database folder into a SQLite file
+ *
+ * Usage: conditions_to_sqlite <url> <folder> <output file> <begin time> [end time] [tag]
+ *
+ * Times are in seconds (optionally with a six-digit fractional part, as in the
+ * database).  Every IOV overlapping [begin time, end time) is retrieved from the
+ * web server and written to the output file, which can then be read by a
+ * DBFolder configured with UseSQLite.
+ */
+
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Providers/DBFolder.h"
+#include "larevt/CalibrationDBI/Providers/DBSQLiteFile.h"
+
+#include <exception>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+
+  if (argc < 5 || argc > 7) {
+    std::cerr << "Usage: " << argv[0] << " <url> <folder> <output file> <begin time> [end time] [tag]" << std::endl;
+    return 1;
+  }
+
+  const std::string url    = argv[1];
+  const std::string folder = argv[2];
+  const std::string output = argv[3];
+  const std::string tag    = (argc > 6) ? argv[6] : "";
+
+  try {
+    lariov::IOVTimeStamp time = lariov::IOVTimeStamp::GetFromString(argv[4]);
+    const lariov::IOVTimeStamp end = (argc > 5) ? lariov::IOVTimeStamp::GetFromString(argv[5])
+                                                : lariov::IOVTimeStamp::MaxTimeStamp();
+
+    lariov::DBFolder source(folder, url, tag);
+    lariov::DBSQLiteWriter sink(output, folder);
+
+    unsigned int n_iovs = 0;
+    while (time < end) {
+      auto data = source.FetchDataset(time);
+      sink.Write(*data, tag);
+      ++n_iovs;
+      std::cout << "IOV " << data->Begin().DBStamp() << " - "
+                << (data->End() == lariov::IOVTimeStamp::MaxTimeStamp() ? std::string("open") : data->End().DBStamp())
+                << ": " << data->NRows() << " channels" << std::endl;
+      if (data->End() == lariov::IOVTimeStamp::MaxTimeStamp()) break;
+      time = data->End();
+    }
+    std::cout << "Wrote " << n_iovs << " IOVs of folder " << folder << " to " << output << std::endl;
+  }
+  catch (std::exception const& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -56,6 +56,9 @@ namespace lariov {
     // clear the caches, if any
     fGoodChannels.reset();
 
+    // and fill them right away, so that const queries never modify the object
+    if (raw::isValidChannelID(fMaxChannel)) FillGoodChannels();
+
   } // SimpleChannelStatus::Setup()
 
 
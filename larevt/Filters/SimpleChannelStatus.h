@@ -142,7 +142,7 @@ namespace lariov {
     raw::ChannelID_t fMaxChannel; ///< largest ID among existing channels
     raw::ChannelID_t fMaxPresentChannel; ///< largest ID among present channels
 
-    /// cached set of good channels (lazy evaluation)
+    /// cached set of good channels (filled by Setup())
     mutable std::unique_ptr<ChannelSet_t> fGoodChannels;
 
     /// Fills the collection of good channels
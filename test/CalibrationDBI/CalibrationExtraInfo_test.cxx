@@ -0,0 +1,81 @@
+/**
+ * @file   CalibrationExtraInfo_test.cxx
+ * @brief  Test of the extra info held out of line by calibration rows
+ *
+ * Rows without extra data hold nothing and share one empty info.  The last
+ * test case reports the memory of a 100000-channel PMT gain snapshot, and
+ * what it took with the info embedded in every row.
+ */
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( calibration_extra_info_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/IOVData/CalibrationExtraInfo.h"
+#include "larevt/CalibrationDBI/IOVData/ElectronicsCalib.h"
+#include "larevt/CalibrationDBI/IOVData/PmtGain.h"
+#include "larevt/CalibrationDBI/IOVData/Snapshot.h"
+
+// C/C++ standard library
+#include <memory>
+#include <string>
+
+
+BOOST_AUTO_TEST_CASE(EmptyInfoIsShared) {
+
+  lariov::PmtGain a(1), b(2);
+  BOOST_CHECK_EQUAL(a.ExtraInfo().GetName(), "PmtGain");
+  BOOST_CHECK(&a.ExtraInfo() == &b.ExtraInfo());
+  BOOST_CHECK(a.ExtraInfo().IsEmpty());
+
+  //setting an empty info of the same calibration keeps the row empty
+  a.SetExtraInfo(lariov::CalibrationExtraInfo("PmtGain"));
+  BOOST_CHECK(&a.ExtraInfo() == &lariov::PmtGain::NoExtraInfo());
+
+  lariov::ElectronicsCalib e(1);
+  BOOST_CHECK_EQUAL(e.ExtraInfo().GetName(), "ElectronicsCalib");
+}
+
+
+BOOST_AUTO_TEST_CASE(InfoWithData) {
+
+  lariov::CalibrationExtraInfo info("PmtGain");
+  info.AddOrReplaceFloatData("saturation", 1.5f);
+  BOOST_CHECK(!info.IsEmpty());
+
+  lariov::PmtGain row(7);
+  row.SetExtraInfo(info);
+  info.AddOrReplaceFloatData("saturation", 2.5f);  //the row holds its own copy
+  BOOST_CHECK_EQUAL(row.ExtraInfo().GetFloatData("saturation"), 1.5f);
+
+  //copies of the row, e.g. in the next snapshot, share it
+  lariov::PmtGain copy(row);
+  BOOST_CHECK(&copy.ExtraInfo() == &row.ExtraInfo());
+
+  //an empty info under another name is kept
+  row.SetExtraInfo(lariov::CalibrationExtraInfo("Other"));
+  BOOST_CHECK_EQUAL(row.ExtraInfo().GetName(), "Other");
+}
+
+
+BOOST_AUTO_TEST_CASE(SnapshotMemory) {
+
+  const unsigned int nchannels = 100000;
+  lariov::Snapshot<lariov::PmtGain> snapshot;
+  for (unsigned int ch=0; ch < nchannels; ++ch) {
+    lariov::PmtGain row(ch);
+    row.SetGain(1.f);
+    row.SetGainErr(0.1f);
+    snapshot.AddOrReplaceRow(row);
+  }
+  BOOST_CHECK_EQUAL(snapshot.NChannels(), nchannels);
+  BOOST_CHECK(sizeof(lariov::PmtGain) < sizeof(lariov::CalibrationExtraInfo));
+
+  const size_t now = nchannels*sizeof(lariov::PmtGain);
+  const size_t embedded = nchannels*(sizeof(lariov::PmtGain) - sizeof(std::shared_ptr<const lariov::CalibrationExtraInfo>)
+                                     + sizeof(lariov::CalibrationExtraInfo));
+  BOOST_TEST_MESSAGE(nchannels << "-channel PmtGain snapshot rows: " << now/1024 << " kB, "
+                     << embedded/1024 << " kB with the extra info embedded in each row");
+}
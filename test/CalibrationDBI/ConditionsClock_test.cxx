@@ -0,0 +1,156 @@
+/**
+ * @file   ConditionsClock_test.cxx
+ * @brief  Test of the ConditionsClock shared by the conditions services
+ */
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( conditionsclock_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/IOVData/IOVDataError.h"
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Providers/ConditionsClock.h"
+
+// C/C++ standard library
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+
+namespace {
+
+  /// A folder whose IOVs are fLength seconds long; an update takes fDelay; prefetches fWindow seconds before the end
+  struct FakeFolder {
+    unsigned long fLength;
+    std::chrono::milliseconds fDelay;
+    unsigned long fWindow = 0;
+    lariov::IOVTimeStamp fBegin = lariov::IOVTimeStamp::MaxTimeStamp();
+    lariov::IOVTimeStamp fEnd = lariov::IOVTimeStamp::MaxTimeStamp();
+    std::atomic<int> fUpdates{0};
+    std::atomic<int> fPrefetches{0};
+    bool fFail = false;
+
+    FakeFolder(unsigned long length, int delay_ms = 0) : fLength(length), fDelay(delay_ms) {}
+
+    void Watch(lariov::ConditionsClock& clock) {
+      clock.Watch("fake",
+                  [this](const lariov::IOVTimeStamp& ts) { return ts >= fBegin && ts < fEnd; },
+                  [this](lariov::DBTimeStamp_t ts) { this->Update(ts); },
+                  [this](const lariov::IOVTimeStamp& ts) { this->MaybePrefetch(ts); });
+    }
+
+    void MaybePrefetch(const lariov::IOVTimeStamp& ts) {
+      if (fWindow > 0 && ts.Stamp() + fWindow >= fEnd.Stamp()) ++fPrefetches;
+    }
+
+    void Update(lariov::DBTimeStamp_t ts) {
+      std::this_thread::sleep_for(fDelay);
+      if (fFail) throw lariov::IOVDataError("fake folder: no data");
+      const unsigned long sec = ts/1000000000ULL;
+      fBegin = lariov::IOVTimeStamp(sec - sec%fLength);
+      fEnd = lariov::IOVTimeStamp(sec - sec%fLength + fLength);
+      ++fUpdates;
+    }
+  };
+
+  lariov::DBTimeStamp_t EventTime(unsigned long sec) { return sec*1000000000ULL + 123456789ULL; }
+
+} // local namespace
+
+
+BOOST_AUTO_TEST_CASE(UpdatesOnlyStaleFolders) {
+
+  lariov::ConditionsClock clock;
+  FakeFolder hourly(3600), daily(86400);
+  hourly.Watch(clock);
+  daily.Watch(clock);
+
+  int events = 0;
+  clock.WatchEvents([&events](lariov::DBTimeStamp_t) { ++events; });
+
+  BOOST_CHECK_EQUAL(clock.NFolders(), 2U);
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000000)), 2U);
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000000)), 0U);
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000010)), 0U);
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000000 + 3600)), 1U);
+
+  BOOST_CHECK_EQUAL(hourly.fUpdates, 2);
+  BOOST_CHECK_EQUAL(daily.fUpdates, 1);
+  BOOST_CHECK_EQUAL(events, 4);
+}
+
+
+BOOST_AUTO_TEST_CASE(CurrentFoldersMayPrefetch) {
+
+  lariov::ConditionsClock clock;
+  FakeFolder hourly(3600), daily(86400);
+  hourly.fWindow = 600;
+  daily.fWindow = 600;
+  hourly.Watch(clock);
+  daily.Watch(clock);
+
+  //an update is not followed by a prefetch in the same event
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000000 + 3000)), 2U);
+  BOOST_CHECK_EQUAL(hourly.fPrefetches, 0);
+
+  //folders still current are asked at every new event time, and only prefetch near their end
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000000 + 3100)), 0U);
+  BOOST_CHECK_EQUAL(hourly.fPrefetches, 1);
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000000 + 3100)), 0U);
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000000 + 3200)), 0U);
+  BOOST_CHECK_EQUAL(hourly.fPrefetches, 2);
+  BOOST_CHECK_EQUAL(daily.fPrefetches, 0);
+
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000000 + 3600)), 1U);
+  BOOST_CHECK_EQUAL(hourly.fPrefetches, 2);
+  BOOST_CHECK_EQUAL(hourly.fUpdates, 2);
+}
+
+
+BOOST_AUTO_TEST_CASE(NoFoldersNoDecoding) {
+
+  //without database folders, event times need not be valid conditions times
+  lariov::ConditionsClock clock;
+  int events = 0;
+  clock.WatchEvents([&events](lariov::DBTimeStamp_t) { ++events; });
+  BOOST_CHECK_EQUAL(clock.Tick(0), 0U);
+  BOOST_CHECK_EQUAL(events, 1);
+}
+
+
+BOOST_AUTO_TEST_CASE(UpdatesInParallel) {
+
+  lariov::ConditionsClock clock;
+  FakeFolder a(3600, 200), b(3600, 200), c(3600, 200);
+  a.Watch(clock);
+  b.Watch(clock);
+  c.Watch(clock);
+
+  auto start = std::chrono::steady_clock::now();
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000000)), 3U);
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  BOOST_CHECK_EQUAL(a.fUpdates + b.fUpdates + c.fUpdates, 3);
+  BOOST_TEST_MESSAGE("Three updates of 0.2 s took " << elapsed << " s through the clock");
+}
+
+
+BOOST_AUTO_TEST_CASE(ErrorsReachTheCaller) {
+
+  lariov::ConditionsClock clock;
+  FakeFolder good(3600, 50), bad(3600);
+  bad.fFail = true;
+  good.Watch(clock);
+  bad.Watch(clock);
+
+  BOOST_CHECK_THROW(clock.Tick(EventTime(1440000000)), lariov::IOVDataError);
+  BOOST_CHECK_EQUAL(good.fUpdates, 1);
+
+  //the failed time is not taken as current: the next event retries
+  bad.fFail = false;
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1440000000)), 1U);
+  BOOST_CHECK_EQUAL(bad.fUpdates, 1);
+}
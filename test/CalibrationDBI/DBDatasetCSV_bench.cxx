@@ -0,0 +1,73 @@
+/**
+ * @file   DBDatasetCSV_bench.cxx
+ * @brief  Timing of the comma-separated conditions file loader
+ *
+ * Reports how long it takes to load a file of a million rows (or the number
+ * given as argument), parsed both by the loader and by the line-by-line
+ * std::stof loop it replaced.  Built with the tests but not run by them.
+ */
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+
+// C/C++ standard library
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// POSIX
+#include <unistd.h>
+
+
+int main(int argc, char** argv) {
+
+  const unsigned int n_rows = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+  std::string content;
+  content.reserve(n_rows*40);
+  char line[128];
+  for (unsigned int ch=0; ch < n_rows; ++ch) {
+    std::snprintf(line, sizeof(line), "%u,%.4f,%.4f,%.4f,%.4f\n", ch, 400.0 + ch%97*0.01, 2.0 + ch%13*0.1, 0.01, 0.02);
+    content += line;
+  }
+
+  char path[] = "/tmp/DBDatasetCSV_bench_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    std::cerr << "Cannot create a temporary file" << std::endl;
+    return 1;
+  }
+  std::FILE* out = fdopen(fd, "w");
+  std::fwrite(content.data(), 1, content.size(), out);
+  std::fclose(out);
+
+  using clock = std::chrono::steady_clock;
+
+  auto start = clock::now();
+  auto data = lariov::DBDataset::ReadCSVFile(path, {"channel", "mean", "rms", "mean_err", "rms_err"},
+                                             {"bigint", "real", "real", "real", "real"});
+  double loader_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+  //the per-field std::string parsing the providers used to do
+  start = clock::now();
+  std::ifstream file(path);
+  std::string text;
+  double sum = 0.;
+  while (std::getline(file, text)) {
+    size_t current_comma = text.find(',');
+    sum += std::stoi(text.substr(0, current_comma));
+    for (int i=0; i < 4; ++i) {
+      size_t next_comma = text.find(',', current_comma+1);
+      sum += std::stof(text.substr(current_comma+1, next_comma-(current_comma+1)));
+      current_comma = next_comma;
+    }
+  }
+  double getline_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+  std::remove(path);
+
+  std::cout << "Loaded " << data->NRows() << " rows in " << loader_ms << " ms (getline/stof loop: "
+            << getline_ms << " ms, checksum " << sum << ")" << std::endl;
+  return (data->NRows() == n_rows) ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file   DBDatasetCSV_test.cxx
+ * @brief  Test of the comma-separated conditions file loader
+ */
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( dbdataset_csv_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+
+// C/C++ standard library
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+  const std::vector<std::string> kNames = {"channel", "mean", "rms", "ok", "comment"};
+  const std::vector<std::string> kTypes = {"bigint", "real", "real", "boolean", "text"};
+
+  std::string WriteTemp(const std::string& content) {
+    char name[] = "/tmp/DBDatasetCSV_test_XXXXXX";
+    int fd = mkstemp(name);
+    std::FILE* out = fdopen(fd, "w");
+    std::fwrite(content.data(), 1, content.size(), out);
+    std::fclose(out);
+    return name;
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(ParseTypedColumns) {
+
+  std::string path = WriteTemp(
+    "# channel,mean,rms,ok,comment\n"
+    "7,400.25,2.5,True,noisy\n"
+    "\n"
+    "   # indented comment\n"
+    "3, 401 ,-1.5e-1,0,\r\n"
+    "5,399,2,1,last,extra"); //no final newline
+  auto data = lariov::DBDataset::ReadCSVFile(path, kNames, kTypes);
+  std::remove(path.c_str());
+
+  BOOST_CHECK_EQUAL(data->NRows(), 3U);
+  BOOST_CHECK(data->IsValid(lariov::IOVTimeStamp(1440000000)));
+
+  //rows come back in channel order
+  BOOST_CHECK_EQUAL(data->Channels()[0], 3U);
+  BOOST_CHECK_EQUAL(data->Channels()[1], 5U);
+  BOOST_CHECK_EQUAL(data->Channels()[2], 7U);
+
+  BOOST_CHECK_CLOSE(data->DoubleValue(0, 1), 401.0, 1e-9);
+  BOOST_CHECK_CLOSE(data->DoubleValue(0, 2), -0.15, 1e-9);
+  BOOST_CHECK(!data->BoolValue(0, 3));
+  BOOST_CHECK_EQUAL(data->StringValue(0, 4), "");
+  BOOST_CHECK(data->BoolValue(1, 3));
+  BOOST_CHECK_EQUAL(data->StringValue(1, 4), "last");
+  BOOST_CHECK_CLOSE(data->DoubleValue(2, 1), 400.25, 1e-9);
+  BOOST_CHECK_EQUAL(data->StringValue(2, 4), "noisy");
+}
+
+
+BOOST_AUTO_TEST_CASE(ShortRowIsAnError) {
+
+  std::string path = WriteTemp("1,2.0,3.0,True,a\n2,2.0\n");
+  BOOST_CHECK_THROW(lariov::DBDataset::ReadCSVFile(path, kNames, kTypes), std::exception);
+  std::remove(path.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(EmptyFile) {
+
+  std::string path = WriteTemp("");
+  auto data = lariov::DBDataset::ReadCSVFile(path, kNames, kTypes);
+  std::remove(path.c_str());
+  BOOST_CHECK_EQUAL(data->NRows(), 0U);
+}
+
+
+BOOST_AUTO_TEST_CASE(ManyRows) {
+
+  //enough rows to check the row count estimate and the reordering, see
+  //DBDatasetCSV_bench.cxx for the timing on a full-size file
+  const unsigned int n_rows = 1000;
+  std::string content;
+  char line[128];
+  for (unsigned int i=0; i < n_rows; ++i) {
+    unsigned int ch = (i*7919) % n_rows; //every channel once, out of order
+    std::snprintf(line, sizeof(line), "%u,%.4f,%.4f,%.4f,%.4f\n", ch, 400.0 + ch%97*0.01, 2.0 + ch%13*0.1, 0.01, 0.02);
+    content += line;
+  }
+  std::string path = WriteTemp(content);
+  auto data = lariov::DBDataset::ReadCSVFile(path, {"channel", "mean", "rms", "mean_err", "rms_err"},
+                                             {"bigint", "real", "real", "real", "real"});
+  std::remove(path.c_str());
+
+  BOOST_CHECK_EQUAL(data->NRows(), n_rows);
+  for (unsigned int r=0; r < n_rows; r += 111) {
+    BOOST_CHECK_EQUAL(data->Channels()[r], r);
+    BOOST_CHECK_EQUAL(data->Row(r), (int)r);
+    BOOST_CHECK_CLOSE(data->DoubleValue(r, 1), 400.0 + r%97*0.01, 1e-6);
+    BOOST_CHECK_CLOSE(data->DoubleValue(r, 2), 2.0 + r%13*0.1, 1e-6);
+  }
+}
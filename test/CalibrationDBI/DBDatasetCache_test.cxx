@@ -0,0 +1,384 @@
+/**
+ * @file   DBDatasetCache_test.cxx
+ * @brief  Test of the on-disk conditions payload cache
+ *
+ * The cache directory is populated by the test itself, so no connection to
+ * a conditions database server is needed.  Each test case works in its own
+ * temporary directory, removed at its end.
+ */
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( dbdataset_cache_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+#include "larevt/CalibrationDBI/Providers/DBDatasetCache.h"
+#include "larevt/CalibrationDBI/Providers/DBFolder.h"
+
+// C/C++ standard library
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// POSIX
+#include <fcntl.h>
+#include <ftw.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+namespace {
+
+  const std::string kURL    = "https://conditions.invalid/app/data";
+  const std::string kFolder = "detpedestals";
+
+  /// A temporary directory, removed with all its content when going out of scope
+  class TempDir {
+    public:
+      TempDir() {
+        char name[] = "/tmp/DBDatasetCache_test_XXXXXX";
+        fPath = mkdtemp(name);
+      }
+      ~TempDir() {
+        nftw(fPath.c_str(), [](const char* path, const struct stat*, int, struct FTW*) { return remove(path); },
+             16, FTW_DEPTH | FTW_PHYS);
+      }
+      TempDir(const TempDir&) = delete;
+      TempDir& operator=(const TempDir&) = delete;
+      operator const std::string&() const { return fPath; }
+      const std::string& Path() const { return fPath; }
+    private:
+      std::string fPath;
+  };
+
+  /// Set the modification time of a file to the given number of seconds ago
+  void Age(const std::string& path, long seconds) {
+    struct timeval times[2];
+    gettimeofday(&times[0], nullptr);
+    times[0].tv_sec -= seconds;
+    times[1] = times[0];
+    utimes(path.c_str(), times);
+  }
+
+  /// A pedestal payload, by default valid from 1440000000 to 1450000000 seconds
+  lariov::DBDataset MakePedestals(const lariov::IOVTimeStamp& begin = 1440000000,
+                                  const lariov::IOVTimeStamp& end = 1450000000, const char* mean = "410.5") {
+    lariov::DBDataset data(begin, end,
+                           {"channel", "mean", "rms", "ok", "comment"},
+                           {"integer", "real", "real", "boolean", "text"});
+    const char* row2[] = {"2", mean, "1.25", "True", "hot"};
+    const char* row0[] = {"0", "400.0", "0.5", "False", ""};
+    data.AddRow(row2);
+    data.AddRow(row0);
+    data.Finalize();
+    return data;
+  }
+
+} // local namespace
+
+
+BOOST_AUTO_TEST_CASE(SerializeRoundTrip) {
+
+  lariov::DBDataset data = MakePedestals();
+  std::string buffer;
+  data.Serialize(buffer);
+
+  auto copy = lariov::DBDataset::Deserialize(buffer.data(), buffer.size());
+  BOOST_CHECK(copy->Begin() == data.Begin());
+  BOOST_CHECK(copy->End() == data.End());
+  BOOST_CHECK_EQUAL(copy->NRows(), 2U);
+  BOOST_CHECK_EQUAL(copy->Channels()[0], 0U);
+  BOOST_CHECK_EQUAL(copy->DoubleValue(1, copy->Column("mean")), 410.5);
+  BOOST_CHECK(copy->BoolValue(1, copy->Column("ok")));
+  BOOST_CHECK_EQUAL(copy->StringValue(1, copy->Column("comment")), "hot");
+
+  BOOST_CHECK_THROW(lariov::DBDataset::Deserialize(buffer.data(), buffer.size()/2), std::exception);
+}
+
+
+BOOST_AUTO_TEST_CASE(FileRoundTrip) {
+
+  TempDir dir;
+  const std::string path = dir.Path() + "/pedestals.bin";
+  const std::string text = dir.Path() + "/pedestals.csv";
+
+  std::shared_ptr<lariov::DBDataset> copy;
+  {
+    lariov::DBDataset data(lariov::IOVTimeStamp(1440000000), lariov::IOVTimeStamp(1450000000),
+                           {"channel", "mean", "gains", "ok", "comment"},
+                           {"integer", "real", "real[]", "boolean", "text"});
+    const char* row2[] = {"2", "410.5", "[1.5, -0.25]", "True", "hot"};
+    const char* row0[] = {"0", "400.0", "[]", "False", ""};
+    data.AddRow(row2);
+    data.AddRow(row0);
+    data.Finalize();
+    data.WriteFile(path);
+    BOOST_CHECK(lariov::DBDataset::IsBinaryFile(path));
+    copy = lariov::DBDataset::ReadFile(path);
+  }
+
+  //the values are read from the file, which may be replaced or removed meanwhile
+  std::remove(path.c_str());
+  BOOST_CHECK(copy->Begin() == lariov::IOVTimeStamp(1440000000));
+  BOOST_CHECK(copy->End() == lariov::IOVTimeStamp(1450000000));
+  BOOST_CHECK_EQUAL(copy->NRows(), 2U);
+  BOOST_CHECK_EQUAL(copy->Channels()[1], 2U);
+  BOOST_CHECK_EQUAL(copy->LongValue(1, 0), 2);
+  BOOST_CHECK_EQUAL(copy->DoubleValue(1, copy->Column("mean")), 410.5);
+  BOOST_CHECK_EQUAL(copy->GetColumn<double>("mean")[0], 400.0);
+  BOOST_CHECK(copy->ArrayValue(0, copy->Column("gains")).empty());
+  lariov::DBDataset::ArrayView gains = copy->GetColumn<lariov::DBDataset::ArrayView>("gains")[1];
+  BOOST_CHECK_EQUAL(gains.size(), 2U);
+  BOOST_CHECK_EQUAL(gains[1], -0.25);
+  BOOST_CHECK(copy->BoolValue(1, copy->Column("ok")));
+  BOOST_CHECK(!copy->GetColumn<bool>("ok")[0]);
+  BOOST_CHECK_EQUAL(copy->StringValue(1, copy->Column("comment")), "hot");
+
+  std::ofstream(text) << "0,400.0\n2,410.5\n";
+  BOOST_CHECK(!lariov::DBDataset::IsBinaryFile(text));
+  BOOST_CHECK(!lariov::DBDataset::IsBinaryFile(path));
+  BOOST_CHECK_THROW(lariov::DBDataset::ReadFile(text), std::exception);
+}
+
+
+BOOST_AUTO_TEST_CASE(PrepopulatedCache) {
+
+  TempDir dir;
+
+  {
+    lariov::DBDatasetCache cache(dir, kURL, kFolder, "");
+    cache.Store(MakePedestals());
+    BOOST_CHECK(!cache.Load(lariov::IOVTimeStamp(1450000000)));
+  }
+
+  // the folder must be served from the cache: the server above does not exist
+  lariov::DBFolder folder(kFolder, kURL);
+  folder.SetCacheDirectory(dir);
+  BOOST_CHECK(folder.UpdateData(1445000000000000000ULL));
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1440000000));
+
+  double mean = 0.;
+  folder.GetNamedChannelData(2, "mean", mean);
+  BOOST_CHECK_EQUAL(mean, 410.5);
+
+  std::vector<lariov::DBChannelID_t> channels;
+  folder.GetChannelList(channels);
+  BOOST_CHECK_EQUAL(channels.size(), 2U);
+
+  // a different tag has its own entries
+  lariov::DBDatasetCache tagged(dir, kURL, kFolder, "v1");
+  BOOST_CHECK(!tagged.Load(lariov::IOVTimeStamp(1445000000)));
+}
+
+
+BOOST_AUTO_TEST_CASE(JobsShareOneFetch) {
+
+  TempDir dir;
+  const std::string fetches = dir.Path() + "/fetches.log";
+
+  //every job misses the cache at the same time; only one may go to the server
+  auto job = [&]() {
+    lariov::DBDatasetCache cache(dir, kURL, kFolder, "", true);
+    auto data = cache.Fetch(lariov::IOVTimeStamp(1445000000), [&](const lariov::IOVTimeStamp&) {
+      std::ofstream(fetches, std::ios::app) << getpid() << "\n";
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      return std::make_shared<const lariov::DBDataset>(MakePedestals());
+    });
+    return data->NRows() == 2U && data->DoubleValue(1, data->Column("mean")) == 410.5;
+  };
+
+  const int njobs = 4;
+  std::vector<pid_t> children;
+  for (int i=0; i < njobs; ++i) {
+    pid_t pid = fork();
+    BOOST_REQUIRE(pid >= 0);
+    if (pid == 0) _exit(job() ? 0 : 1);
+    children.push_back(pid);
+  }
+  for (pid_t pid : children) {
+    int status = -1;
+    waitpid(pid, &status, 0);
+    BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+
+  std::ifstream log(fetches);
+  int nfetches = 0;
+  for (std::string line; std::getline(log, line); ) ++nfetches;
+  BOOST_CHECK_EQUAL(nfetches, 1);
+
+  BOOST_CHECK_EQUAL(lariov::DBDatasetCache::SharedMemoryDirectory().compare(0, 9, "/dev/shm/"), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(ArrayColumns) {
+
+  //arrays used to be cut at 128 values
+  std::string long_array = "[";
+  for (int i=0; i < 300; ++i) long_array += (i ? ", " : "") + std::to_string(0.5*i);
+  long_array += "]";
+
+  lariov::DBDataset data(lariov::IOVTimeStamp(1440000000), lariov::IOVTimeStamp(1450000000),
+                         {"channel", "gains", "comment"}, {"integer", "real[]", "text"});
+  const char* row3[] = {"3", long_array.c_str(), "[1,2]"};
+  const char* row1[] = {"1", " [ 1.5 ,-2e-1,3 ] ", "none"};
+  const char* row2[] = {"2", "[]", ""};
+  data.AddRow(row3);
+  data.AddRow(row1);
+  data.AddRow(row2);
+  data.Finalize();
+  BOOST_CHECK_EQUAL(data.Kind(1), lariov::DBDataset::kArrayColumn);
+
+  std::string buffer;
+  data.Serialize(buffer);
+  auto copy = lariov::DBDataset::Deserialize(buffer.data(), buffer.size());
+
+  for (const lariov::DBDataset* d : std::vector<const lariov::DBDataset*>{&data, copy.get()}) {
+    lariov::DBDataset::ArrayView small = d->ArrayValue(0, 1);
+    BOOST_CHECK_EQUAL(small.size(), 3U);
+    BOOST_CHECK_EQUAL(small[1], -0.2);
+    BOOST_CHECK(d->ArrayValue(1, 1).empty());
+    BOOST_CHECK_EQUAL(d->ArrayValue(2, 1).size(), 300U);
+    BOOST_CHECK_EQUAL(d->ArrayValue(2, 1)[299], 149.5);
+    BOOST_CHECK_EQUAL(d->StringValue(2, 1), long_array);
+  }
+
+  //through a folder, served from a cache directory
+  TempDir dir;
+  lariov::DBDatasetCache(dir, kURL, kFolder, "").Store(data);
+  lariov::DBFolder folder(kFolder, kURL);
+  folder.SetCacheDirectory(dir);
+  BOOST_CHECK(folder.UpdateData(1445000000000000000ULL));
+
+  std::vector<double> values;
+  BOOST_CHECK_EQUAL(folder.GetNamedChannelData(3, "gains", values), 0);
+  BOOST_CHECK_EQUAL(values.size(), 300U);
+  lariov::DBDataset::ArrayView view;
+  BOOST_CHECK_EQUAL(folder.GetNamedChannelData(1, "gains", view), 0);
+  BOOST_CHECK_EQUAL(view.size(), 3U);
+
+  //text columns are parsed on request, unbracketed ones are refused
+  BOOST_CHECK_EQUAL(folder.GetNamedChannelData(3, "comment", values), 0);
+  BOOST_CHECK_EQUAL(values.size(), 2U);
+  BOOST_CHECK_EQUAL(folder.GetNamedChannelData(1, "comment", values), -2);
+  BOOST_CHECK_EQUAL(folder.GetNamedChannelData(1, "comment", view), -1);
+}
+
+
+BOOST_AUTO_TEST_CASE(MostSpecificFileWins) {
+
+  TempDir dir;
+  lariov::DBDatasetCache cache(dir, kURL, kFolder, "v1");
+  cache.Store(MakePedestals(1440000000, 1460000000, "400"));
+  cache.Store(MakePedestals(1445000000, 1450000000, "401"));
+  cache.Store(MakePedestals(1440000000, 1450000000, "402"));
+  Age(cache.Directory() + "/1440000000.000000_1450000000.000000.iov", 60);
+
+  //the IOV starting last covers this time best
+  auto data = cache.Load(lariov::IOVTimeStamp(1446000000));
+  BOOST_REQUIRE(data);
+  BOOST_CHECK_EQUAL(data->DoubleValue(1, data->Column("mean")), 401.);
+
+  //of those starting together, the one written last
+  data = cache.Load(lariov::IOVTimeStamp(1441000000));
+  BOOST_REQUIRE(data);
+  BOOST_CHECK_EQUAL(data->DoubleValue(1, data->Column("mean")), 400.);
+}
+
+
+BOOST_AUTO_TEST_CASE(UntaggedFilesExpire) {
+
+  TempDir dir;
+  lariov::DBDatasetCache untagged(dir, kURL, kFolder, "");
+  lariov::DBDatasetCache tagged(dir, kURL, kFolder, "v1");
+  untagged.SetMaxAge(3600);
+  tagged.SetMaxAge(3600);
+  untagged.Store(MakePedestals());
+  tagged.Store(MakePedestals());
+  BOOST_CHECK(untagged.Load(lariov::IOVTimeStamp(1445000000)));
+
+  //the database may have changed since: the file is not used any more, unless for a tag
+  Age(untagged.Directory() + "/1440000000.000000_1450000000.000000.iov", 7200);
+  Age(tagged.Directory() + "/1440000000.000000_1450000000.000000.iov", 7200);
+  BOOST_CHECK(!untagged.Load(lariov::IOVTimeStamp(1445000000)));
+  BOOST_CHECK(tagged.Load(lariov::IOVTimeStamp(1445000000)));
+
+  //fetching it again renews it
+  untagged.Fetch(lariov::IOVTimeStamp(1445000000), [](const lariov::IOVTimeStamp&) {
+    return std::make_shared<const lariov::DBDataset>(MakePedestals());
+  });
+  BOOST_CHECK(untagged.Load(lariov::IOVTimeStamp(1445000000)));
+}
+
+
+BOOST_AUTO_TEST_CASE(OpenEndedFilesAreShortLived) {
+
+  TempDir dir;
+  lariov::DBDatasetCache cache(dir, kURL, kFolder, "");
+  cache.SetOpenEndedMaxAge(60);
+  cache.Store(MakePedestals(1440000000, lariov::IOVTimeStamp::MaxTimeStamp()));
+  const std::string file = cache.Directory() + "/1440000000.000000_max.iov";
+
+  //the next insertion in the database would close this IOV
+  BOOST_CHECK(cache.Load(lariov::IOVTimeStamp(1445000000)));
+  Age(file, 120);
+  BOOST_CHECK(!cache.Load(lariov::IOVTimeStamp(1445000000)));
+
+  //and the next store removes it
+  cache.Store(MakePedestals(1430000000, 1440000000));
+  BOOST_CHECK(access(file.c_str(), F_OK) != 0);
+}
+
+
+BOOST_AUTO_TEST_CASE(LeastRecentlyUsedAreEvicted) {
+
+  TempDir dir;
+  lariov::DBDatasetCache cache(dir, kURL, kFolder, "v1");
+  cache.Store(MakePedestals(1440000000, 1450000000));
+  cache.Store(MakePedestals(1450000000, 1460000000));
+  struct stat st;
+  BOOST_REQUIRE(stat((cache.Directory() + "/1440000000.000000_1450000000.000000.iov").c_str(), &st) == 0);
+
+  //room for two files; the first one was used more recently than the second
+  cache.SetMaxSize(2*st.st_size);
+  Age(cache.Directory() + "/1440000000.000000_1450000000.000000.iov", 600);
+  Age(cache.Directory() + "/1450000000.000000_1460000000.000000.iov", 600);
+  BOOST_CHECK(cache.Load(lariov::IOVTimeStamp(1445000000)));
+
+  cache.Store(MakePedestals(1460000000, 1470000000));
+  BOOST_CHECK(cache.Load(lariov::IOVTimeStamp(1445000000)));
+  BOOST_CHECK(!cache.Load(lariov::IOVTimeStamp(1455000000)));
+  BOOST_CHECK(cache.Load(lariov::IOVTimeStamp(1465000000)));
+}
+
+
+BOOST_AUTO_TEST_CASE(LockWaitIsBounded) {
+
+  TempDir dir;
+  lariov::DBDatasetCache cache(dir, kURL, kFolder, "", true);
+  cache.SetLockWait(1);
+
+  //another job holds the lock and never finishes its fetch
+  int fd = open((cache.Directory() + "/.fetch.lock").c_str(), O_RDWR | O_CREAT, 0664);
+  BOOST_REQUIRE(fd >= 0);
+  BOOST_REQUIRE(flock(fd, LOCK_EX) == 0);
+
+  int fetched = 0;
+  auto data = cache.Fetch(lariov::IOVTimeStamp(1445000000), [&fetched](const lariov::IOVTimeStamp&) {
+    ++fetched;
+    return std::make_shared<const lariov::DBDataset>(MakePedestals());
+  });
+  BOOST_CHECK_EQUAL(fetched, 1);
+  BOOST_CHECK(data->IsValid(lariov::IOVTimeStamp(1445000000)));
+  close(fd);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file   DBFetchPool_test.cxx
+ * @brief  Test of the thread pool running conditions fetches
+ */
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( dbfetchpool_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/Providers/DBFetchPool.h"
+
+// C/C++ standard library
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+
+BOOST_AUTO_TEST_CASE(ResultsAndErrors) {
+
+  lariov::DBFetchPool pool(2);
+  BOOST_CHECK_EQUAL(pool.NThreads(), 2U);
+
+  std::vector<lariov::DBFetchPool::Future<int>> results;
+  for (int i=0; i < 20; ++i) results.push_back(pool.Submit([i]() { return i*i; }));
+  int sum = 0;
+  for (auto& result : results) sum += result.get();
+  BOOST_CHECK_EQUAL(sum, 2470);
+
+  auto failed = pool.Submit([]() -> int { throw std::runtime_error("no data"); });
+  BOOST_CHECK_THROW(failed.get(), std::runtime_error);
+}
+
+
+BOOST_AUTO_TEST_CASE(NestedWaitsDoNotBlock) {
+
+  //every thread of the pool waits for a task queued behind it
+  lariov::DBFetchPool pool(1);
+  auto outer = pool.Submit([&pool]() {
+    auto inner = pool.Submit([]() { return 42; });
+    return inner.get() + 1;
+  });
+  BOOST_CHECK_EQUAL(outer.get(), 43);
+}
+
+
+BOOST_AUTO_TEST_CASE(DroppedTasksDoNotRun) {
+
+  //the only thread is held until all the tasks behind it are dropped
+  std::atomic<int> runs(0);
+  {
+    lariov::DBFetchPool pool(1);
+    std::promise<void> started, release;
+    std::shared_future<void> released = release.get_future().share();
+    auto blocker = pool.Submit([&started, released]() { started.set_value(); released.wait(); return 0; });
+    started.get_future().wait();
+    for (int i=0; i < 10; ++i) {
+      auto dropped = pool.Submit([&runs]() { ++runs; return 0; });
+    }
+    release.set_value();
+    blocker.get();
+  }
+  BOOST_CHECK_EQUAL(runs, 0);
+
+  //a task already started is waited for
+  std::atomic<bool> done(false);
+  {
+    lariov::DBFetchPool pool(1);
+    auto started = pool.Submit([&done]() { done = true; return 0; });
+    started.get();
+  }
+  BOOST_CHECK(done);
+}
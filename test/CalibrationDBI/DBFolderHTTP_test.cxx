@@ -0,0 +1,853 @@
+/**
+ * @file   DBFolderHTTP_test.cxx
+ * @brief  Test of DBFolder fetches against a local mock conditions server
+ *
+ * The server answers /data queries for any folder with a ten-channel
+ * payload, after a fixed delay standing for the server round trip, gzipped
+ * on request if it is told to.  When several folders cross an IOV boundary
+ * at once, the ConditionsClock should wait about one delay rather than one
+ * per folder; preloaded IOVs should need no request at all, and folders
+ * reading the same data should share one request.  The server can also be
+ * made to fail, to be late or to hold its answers, for the retries, the
+ * stale-data policy and the prefetch of the next IOV.
+ * Connections are kept open unless the client asks otherwise, so that
+ * reusing them can be measured.  The server may honour a channel subset in
+ * the query or ignore it; either way a folder reading a subset only gets
+ * the rows of those channels.
+ */
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( dbfolderhttp_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Providers/ConditionsClock.h"
+#include "larevt/CalibrationDBI/Providers/DBConnectionPool.h"
+#include "larevt/CalibrationDBI/Providers/DBFetchPool.h"
+#include "larevt/CalibrationDBI/Providers/DBFolder.h"
+#include "larevt/CalibrationDBI/Providers/DBFolderRegistry.h"
+#include "larevt/CalibrationDBI/Providers/DBWebReader.h"
+#include "larevt/CalibrationDBI/Providers/WebError.h"
+
+// C/C++ standard library
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// POSIX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// zlib
+#include <zlib.h>
+
+
+namespace {
+
+  const unsigned long kIOVLength = 10000000; //seconds
+
+  /// gzip-encode a response body
+  std::string Gzip(const std::string& text) {
+    z_stream zs;
+    std::memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, text.size()), '\0');
+    zs.next_in = (Bytef*)text.data();
+    zs.avail_in = text.size();
+    zs.next_out = (Bytef*)&out[0];
+    zs.avail_out = out.size();
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+  }
+
+  /// Minimal HTTP server speaking the conditions /data protocol
+  class MockServer {
+
+    public:
+
+      explicit MockServer(std::chrono::milliseconds delay) :
+        fDelay(delay), fRequests(0), fNConnections(0), fFailures(0), fFailStatus(503), fChannels(10), fCompress(false), fBytesSent(0),
+        fChannelQuery(false), fHeld(false), fHeldIOV(0), fStop(false) {
+        fSocket = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(fSocket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        if (bind(fSocket, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fSocket, 16) != 0) {
+          throw std::runtime_error("MockServer: cannot listen on the loopback interface");
+        }
+        socklen_t len = sizeof(addr);
+        getsockname(fSocket, (sockaddr*)&addr, &len);
+        fPort = ntohs(addr.sin_port);
+        fAccept = std::thread(&MockServer::Accept, this);
+      }
+
+      ~MockServer() {
+        fHeld = false;
+        fStop = true;
+        shutdown(fSocket, SHUT_RDWR);
+        close(fSocket);
+        fAccept.join();
+        std::vector<std::thread> connections;
+        {
+          //clients keep their connections open: hang up on them
+          std::lock_guard<std::mutex> lock(fMutex);
+          for (int conn : fOpen) shutdown(conn, SHUT_RDWR);
+          connections.swap(fConnections);
+        }
+        for (auto& thread : connections) thread.join();
+      }
+
+      std::string URL() const { return "http://127.0.0.1:" + std::to_string(fPort) + "/mockdb"; }
+      int NRequests() const { return fRequests; }
+      int NConnections() const { return fNConnections; }
+
+      /// Answer the next n requests with an error, 503 Service Unavailable by default
+      void FailNext(int n, int status = 503) { fFailStatus = status; fFailures = n; }
+
+      /// Number of channels in each payload
+      void SetChannels(int n) { fChannels = n; }
+
+      /// Gzip the payloads of clients accepting it
+      void SetCompression(bool compress) { fCompress = compress; }
+
+      /// Bytes of response bodies sent so far
+      size_t BytesSent() const { return fBytesSent; }
+
+      /// Only send the channels asked for with c=first-last,ch,...; otherwise the parameter is ignored
+      void SetChannelQuery(bool honour) { fChannelQuery = honour; }
+
+      /// Keep requests waiting, after counting them, until released; only those for the IOV starting at iov if given
+      void Hold(bool held, unsigned long iov = 0) { fHeldIOV = iov; fHeld = held; }
+
+      /// Wait until n requests have been received
+      void WaitForRequests(int n) const {
+        while (fRequests < n) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+
+    private:
+
+      void Accept() {
+        while (!fStop) {
+          int conn = accept(fSocket, nullptr, nullptr);
+          if (conn < 0) continue;
+          ++fNConnections;
+          std::lock_guard<std::mutex> lock(fMutex);
+          fOpen.insert(conn);
+          fConnections.emplace_back(&MockServer::Serve, this, conn);
+        }
+      }
+
+      static std::string Parameter(const std::string& request, const std::string& name) {
+        size_t pos = request.find(name + "=");
+        if (pos == std::string::npos) return "";
+        pos += name.size() + 1;
+        return request.substr(pos, request.find_first_of("& ", pos) - pos);
+      }
+
+      /// True if ch is in a channel list such as "0-3,7"
+      static bool Selected(const std::string& channels, int ch) {
+        std::istringstream in(channels);
+        std::string item;
+        while (std::getline(in, item, ',')) {
+          const size_t dash = item.find('-');
+          const int first = std::atoi(item.c_str());
+          const int last = (dash == std::string::npos) ? first : std::atoi(item.c_str() + dash + 1);
+          if (ch >= first && ch <= last) return true;
+        }
+        return false;
+      }
+
+      void Serve(int conn) {
+        std::string received;
+        char buf[4096];
+        while (true) {
+          size_t end;
+          while ((end = received.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = read(conn, buf, sizeof(buf));
+            if (n <= 0) break;
+            received.append(buf, n);
+          }
+          if (end == std::string::npos) break;
+          const std::string request = received.substr(0, end + 4);
+          received.erase(0, end + 4);
+          if (!this->Respond(conn, request)) break;
+        }
+        std::lock_guard<std::mutex> lock(fMutex);
+        fOpen.erase(conn);
+        close(conn);
+      }
+
+      /// Answer one request; false if the connection is to be closed
+      bool Respond(int conn, const std::string& request) {
+        ++fRequests;
+        //IOVs are kIOVLength seconds long
+        const unsigned long t = std::strtoul(Parameter(request, "t").c_str(), nullptr, 10);
+        const unsigned long begin = t - t%kIOVLength;
+        while (fHeld && (fHeldIOV == 0 || fHeldIOV == begin)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(fDelay);
+
+        const std::string folder = Parameter(request, "f");
+        std::string status = "200 OK", body;
+        if (fFailures.fetch_sub(1) > 0) {
+          status = std::to_string(fFailStatus) + " Failing";
+          body = "busy\n";
+        }
+        else if (request.compare(0, 4, "GET ") != 0 || request.find("/mockdb/data?") == std::string::npos
+            || folder == "missing") {
+          status = "404 Not Found";
+          body = "no such folder\n";
+        }
+        else {
+          std::ostringstream payload;
+          payload << begin << ".000000\n" << begin + kIOVLength << ".000000\n"
+                  << "channel,mean\nbigint,real\n";
+          const std::string channels = fChannelQuery ? Parameter(request, "c") : "";
+          for (int ch=0; ch < fChannels; ++ch) {
+            if (!channels.empty() && !Selected(channels, ch)) continue;
+            payload << ch << "," << 400 + ch + begin/kIOVLength << "\n";
+          }
+          body = payload.str();
+        }
+
+        std::string encoding;
+        std::string lower(request);
+        for (char& c : lower) c = std::tolower((unsigned char)c);
+        const size_t accept = lower.find("\r\naccept-encoding:");
+        if (fCompress && accept != std::string::npos
+            && lower.substr(accept, lower.find("\r\n", accept+2) - accept).find("gzip") != std::string::npos) {
+          body = Gzip(body);
+          encoding = "Content-Encoding: gzip\r\n";
+        }
+        fBytesSent += body.size();
+
+        const bool keep = (lower.find("\r\nconnection: close") == std::string::npos);
+        std::ostringstream response;
+        response << "HTTP/1.1 " << status << "\r\nContent-Type: text/plain\r\n" << encoding
+                 << "Content-Length: " << body.size() << "\r\nConnection: " << (keep ? "keep-alive" : "close")
+                 << "\r\n\r\n" << body;
+        const std::string out = response.str();
+        for (size_t sent = 0; sent < out.size(); ) {
+          ssize_t n = send(conn, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+          if (n <= 0) return false;
+          sent += n;
+        }
+        return keep;
+      }
+
+      std::chrono::milliseconds fDelay;
+      std::atomic<int>          fRequests;
+      std::atomic<int>          fNConnections;
+      std::atomic<int>          fFailures;
+      std::atomic<int>          fFailStatus;
+      std::atomic<int>          fChannels;
+      std::atomic<bool>         fCompress;
+      std::atomic<size_t>       fBytesSent;
+      std::atomic<bool>         fChannelQuery;
+      std::atomic<bool>         fHeld;
+      std::atomic<unsigned long> fHeldIOV;      //Start of the IOV held, 0 for all
+      std::atomic<bool>         fStop;
+      int                       fSocket;
+      unsigned short            fPort;
+      std::mutex                fMutex;
+      std::vector<std::thread>  fConnections;
+      std::set<int>             fOpen;          //Connections being served
+      std::thread               fAccept;
+  };
+
+  lariov::DBTimeStamp_t EventTime(unsigned long sec) { return sec*1000000000ULL; }
+
+  double Seconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+  }
+
+  /// Turns the pool keep-alive off for a scope, back on however the scope is left
+  struct NoKeepAlive {
+    NoKeepAlive() { lariov::DBConnectionPool::SetKeepAlive(false); }
+    ~NoKeepAlive() { lariov::DBConnectionPool::SetKeepAlive(true); }
+  };
+
+  /// Sets the most handles per server for a scope, restoring the previous value
+  struct MaxPerHost {
+    explicit MaxPerHost(size_t n) : fPrevious(lariov::DBConnectionPool::MaxPerHost()) {
+      lariov::DBConnectionPool::SetMaxPerHost(n);
+    }
+    ~MaxPerHost() { lariov::DBConnectionPool::SetMaxPerHost(fPrevious); }
+    size_t fPrevious;
+  };
+
+} // local namespace
+
+
+BOOST_AUTO_TEST_CASE(FetchFromServer) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  lariov::DBFolder folder("pedestals", server.URL());
+
+  BOOST_CHECK(folder.UpdateData(EventTime(1445000000)));
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1440000000));
+  BOOST_CHECK(folder.CachedEnd() == lariov::IOVTimeStamp(1450000000));
+
+  double mean = 0.;
+  folder.GetNamedChannelData(3, "mean", mean);
+  BOOST_CHECK_CLOSE(mean, 400. + 3 + 144, 1e-6);
+
+  BOOST_CHECK(!folder.UpdateData(EventTime(1445000001)));
+  BOOST_CHECK_EQUAL(server.NRequests(), 1);
+
+  lariov::DBFolder missing("missing", server.URL());
+  BOOST_CHECK_THROW(missing.UpdateData(EventTime(1445000000)), lariov::WebError);
+}
+
+
+BOOST_AUTO_TEST_CASE(BoundaryCostsSlowestFolder) {
+
+  const std::chrono::milliseconds delay(300);
+  MockServer server(delay);
+
+  const char* names[] = {"pedestals", "channelstatus", "pmtgain", "electronicscalib"};
+  std::vector<std::unique_ptr<lariov::DBFolder>> folders;
+  lariov::ConditionsClock clock;
+  for (const char* name : names) {
+    folders.emplace_back(new lariov::DBFolder(name, server.URL()));
+    lariov::DBFolder& folder = *folders.back();
+    clock.Watch(name,
+                [&folder](const lariov::IOVTimeStamp& ts) {
+                  return folder.CachedData() && ts >= folder.CachedStart() && ts < folder.CachedEnd(); },
+                [&folder](lariov::DBTimeStamp_t ts) { folder.UpdateData(ts); });
+  }
+  BOOST_REQUIRE(folders.size() <= lariov::DBFetchPool::kDefaultThreads);
+
+  //one folder after the other
+  auto start = std::chrono::steady_clock::now();
+  for (auto& folder : folders) folder->UpdateData(EventTime(1445000000));
+  const double serial = Seconds(std::chrono::steady_clock::now() - start);
+
+  //all of them at the next IOV boundary
+  start = std::chrono::steady_clock::now();
+  BOOST_CHECK_EQUAL(clock.Tick(EventTime(1455000000)), folders.size());
+  const double parallel = Seconds(std::chrono::steady_clock::now() - start);
+
+  for (auto& folder : folders) BOOST_CHECK(folder->CachedStart() == lariov::IOVTimeStamp(1450000000));
+  BOOST_CHECK_EQUAL(server.NRequests(), 2*(int)folders.size());
+
+  const double round_trip = std::chrono::duration<double>(delay).count();
+  BOOST_CHECK(serial >= folders.size()*round_trip);
+  BOOST_TEST_MESSAGE("Boundary with " << folders.size() << " folders: " << serial << " s one by one, "
+                     << parallel << " s through the clock");
+}
+
+
+BOOST_AUTO_TEST_CASE(PreloadedSwitchesNeedNoRequests) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  lariov::DBFolder folder("pedestals", server.URL());
+
+  //a run spanning three IOVs
+  BOOST_CHECK_EQUAL(folder.Preload(lariov::IOVTimeStamp(1445000000), lariov::IOVTimeStamp(1465000000)), 3U);
+  BOOST_CHECK_EQUAL(server.NRequests(), 3);
+
+  for (unsigned long sec : {1445000000UL, 1455000000UL, 1465000000UL, 1446000000UL}) {
+    BOOST_CHECK(folder.UpdateData(EventTime(sec)));
+    double mean = 0.;
+    folder.GetNamedChannelData(0, "mean", mean);
+    BOOST_CHECK_CLOSE(mean, 400. + sec/kIOVLength, 1e-6);
+  }
+  BOOST_CHECK_EQUAL(server.NRequests(), 3);
+
+  //beyond the preloaded range
+  BOOST_CHECK(folder.UpdateData(EventTime(1475000000)));
+  BOOST_CHECK_EQUAL(server.NRequests(), 4);
+}
+
+
+BOOST_AUTO_TEST_CASE(PrefetchedIOVIsSwappedIn) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  lariov::DBFolder folder("pedestals", server.URL());
+  folder.SetPrefetchWindow(kIOVLength/10);
+
+  //far from the end of the IOV: nothing is prefetched
+  BOOST_CHECK(folder.UpdateData(EventTime(1445000000)));
+  BOOST_CHECK(!folder.UpdateData(EventTime(1448000000)));
+  BOOST_CHECK_EQUAL(server.NRequests(), 1);
+
+  //close to it, the next IOV is fetched once, in the background
+  BOOST_CHECK(!folder.UpdateData(EventTime(1449500000)));
+  BOOST_CHECK(!folder.UpdateData(EventTime(1449600000)));
+  server.WaitForRequests(2);
+
+  //and taken over at the boundary without another request
+  BOOST_CHECK(folder.UpdateData(EventTime(1450000000)));
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1450000000));
+  double mean = 0.;
+  folder.GetNamedChannelData(0, "mean", mean);
+  BOOST_CHECK_CLOSE(mean, 400. + 145, 1e-6);
+  BOOST_CHECK_EQUAL(server.NRequests(), 2);
+}
+
+
+BOOST_AUTO_TEST_CASE(WrongPrefetchFallsBackToFetch) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  lariov::DBFolder folder("pedestals", server.URL());
+  folder.SetPrefetchWindow(kIOVLength/10);
+
+  BOOST_CHECK(folder.UpdateData(EventTime(1449500000)));
+  BOOST_CHECK(!folder.UpdateData(EventTime(1449500001)));
+  server.WaitForRequests(2);
+
+  //the events skip the prefetched IOV: it is not served, the right one is fetched
+  BOOST_CHECK(folder.UpdateData(EventTime(1475000000)));
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1470000000));
+  double mean = 0.;
+  folder.GetNamedChannelData(0, "mean", mean);
+  BOOST_CHECK_CLOSE(mean, 400. + 147, 1e-6);
+  BOOST_CHECK_EQUAL(server.NRequests(), 3);
+}
+
+
+BOOST_AUTO_TEST_CASE(PrefetchOfAnotherIOVIsNotWaitedFor) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  lariov::DBFolder folder("pedestals", server.URL());
+  folder.SetPrefetchWindow(kIOVLength/10);
+  BOOST_CHECK(folder.UpdateData(EventTime(1449500000)));
+
+  //the prefetched IOV does not come; events jump past it, then back before it
+  server.Hold(true, 1450000000);
+  BOOST_CHECK(!folder.UpdateData(EventTime(1449500001)));
+  server.WaitForRequests(2);
+  std::atomic<int> updated(0);
+  std::thread jump([&folder, &updated]() {
+    if (folder.UpdateData(EventTime(1475000000))) ++updated;
+    if (folder.UpdateData(EventTime(1435000000))) ++updated;
+  });
+  for (int i=0; i < 10000 && updated < 2; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  BOOST_CHECK_EQUAL(updated.load(), 2);
+  server.Hold(false);
+  jump.join();
+
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1430000000));
+  BOOST_CHECK_EQUAL(server.NRequests(), 4);
+}
+
+
+BOOST_AUTO_TEST_CASE(FailedPrefetchIsRetried) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  lariov::DBFolder folder("pedestals", server.URL());
+  folder.SetPrefetchWindow(kIOVLength/10);
+  folder.SetRetries(1, 10);
+
+  BOOST_CHECK(folder.UpdateData(EventTime(1445000000)));
+
+  //the prefetch meets a busy server, twice, and gives up
+  server.FailNext(2);
+  BOOST_CHECK(!folder.UpdateData(EventTime(1449500000)));
+  server.WaitForRequests(3);
+
+  //one of the next events issues it again, once it is known to have failed
+  for (unsigned long sec = 1449500001; server.NRequests() < 4 && sec < 1449510000; ++sec) {
+    BOOST_CHECK(!folder.UpdateData(EventTime(sec)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  BOOST_CHECK_EQUAL(server.NRequests(), 4);
+
+  BOOST_CHECK(folder.UpdateData(EventTime(1450000000)));
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1450000000));
+  BOOST_CHECK_EQUAL(server.NRequests(), 4);
+}
+
+
+BOOST_AUTO_TEST_CASE(FolderDoesNotWaitForPrefetch) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  auto folder = std::make_unique<lariov::DBFolder>("pedestals", server.URL());
+  folder->SetPrefetchWindow(kIOVLength/10);
+  BOOST_CHECK(folder->UpdateData(EventTime(1449500000)));
+
+  //the answer to the prefetch does not come until the folder is gone
+  server.Hold(true);
+  BOOST_CHECK(!folder->UpdateData(EventTime(1449500001)));
+  server.WaitForRequests(2);
+  std::atomic<bool> destroyed(false);
+  std::thread destroy([&folder, &destroyed]() { folder.reset(); destroyed = true; });
+  for (int i=0; i < 10000 && !destroyed; ++i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  BOOST_CHECK(destroyed);
+  server.Hold(false);
+  destroy.join();
+}
+
+
+BOOST_AUTO_TEST_CASE(IdenticalFoldersShareFetches) {
+
+  MockServer server(std::chrono::milliseconds(200));
+  const size_t nshared = lariov::DBFolderRegistry::NFolders();
+  {
+    //two algorithms updating at the same event, from different threads
+    lariov::DBFolder first("pedestals", server.URL());
+    lariov::DBFolder second("pedestals", server.URL() + "/");
+    BOOST_CHECK_EQUAL(lariov::DBFolderRegistry::NFolders(), nshared + 1);
+
+    std::thread other([&second]() { second.UpdateData(EventTime(1445000000)); });
+    first.UpdateData(EventTime(1445000000));
+    other.join();
+    BOOST_CHECK_EQUAL(server.NRequests(), 1);
+    BOOST_CHECK(first.CachedData() == second.CachedData());
+
+    //a payload already held is handed over at once
+    first.UpdateData(EventTime(1455000000));
+    lariov::DBFolder third("pedestals", server.URL());
+    third.UpdateData(EventTime(1456000000));
+    BOOST_CHECK_EQUAL(server.NRequests(), 2);
+    BOOST_CHECK(first.CachedData() == third.CachedData());
+
+    //another tag is other data
+    lariov::DBFolder tagged("pedestals", server.URL(), "v2");
+    tagged.UpdateData(EventTime(1445000000));
+    BOOST_CHECK_EQUAL(server.NRequests(), 3);
+  }
+  BOOST_CHECK_EQUAL(lariov::DBFolderRegistry::NFolders(), nshared);
+}
+
+
+BOOST_AUTO_TEST_CASE(ServerErrorsAreRetried) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  lariov::DBFolder folder("pedestals", server.URL());
+  folder.SetRetries(2, 10);
+
+  server.FailNext(2);
+  BOOST_CHECK(folder.UpdateData(EventTime(1445000000)));
+  BOOST_CHECK_EQUAL(server.NRequests(), 3);
+
+  server.FailNext(3);
+  BOOST_CHECK_THROW(folder.UpdateData(EventTime(1455000000)), lariov::WebError);
+  BOOST_CHECK_EQUAL(server.NRequests(), 6);
+
+  //a missing folder is not going to appear
+  lariov::DBFolder missing("missing", server.URL());
+  missing.SetRetries(2, 10);
+  BOOST_CHECK_THROW(missing.UpdateData(EventTime(1445000000)), lariov::WebError);
+  BOOST_CHECK_EQUAL(server.NRequests(), 7);
+}
+
+
+BOOST_AUTO_TEST_CASE(LatePayloadKeepsPreviousIOV) {
+
+  MockServer server(std::chrono::milliseconds(400));
+  lariov::DBFolder folder("pedestals", server.URL());
+  folder.SetStaleDeadline(50);
+
+  //nothing to serve yet: wait
+  BOOST_CHECK(folder.UpdateData(EventTime(1445000000)));
+
+  auto start = std::chrono::steady_clock::now();
+  BOOST_CHECK(!folder.UpdateData(EventTime(1455000000)));
+  BOOST_CHECK(!folder.UpdateData(EventTime(1455000001)));
+  const double waited = Seconds(std::chrono::steady_clock::now() - start);
+  BOOST_CHECK(folder.IsStale());
+  BOOST_CHECK_EQUAL(folder.NStaleUpdates(), 2U);
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1440000000));
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(600));
+  BOOST_CHECK(folder.UpdateData(EventTime(1455000002)));
+  BOOST_CHECK(!folder.IsStale());
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1450000000));
+  BOOST_CHECK_EQUAL(server.NRequests(), 2);
+  BOOST_TEST_MESSAGE("Two updates past a late IOV took " << waited << " s with a server taking 0.4 s");
+}
+
+
+BOOST_AUTO_TEST_CASE(OnlyTransientFailuresKeepPreviousIOV) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  lariov::DBFolder folder("pedestals", server.URL());
+  folder.SetStaleDeadline(200);
+  folder.SetRetries(0, 10);
+  BOOST_CHECK(folder.UpdateData(EventTime(1445000000)));
+
+  //a failing server is waited out, the request being repeated at a later update
+  server.FailNext(1);
+  BOOST_CHECK(!folder.UpdateData(EventTime(1455000000)));
+  BOOST_CHECK(folder.IsStale());
+  BOOST_CHECK(!folder.UpdateData(EventTime(1455000001)));
+  server.WaitForRequests(3);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  BOOST_CHECK(folder.UpdateData(EventTime(1455000002)));
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1450000000));
+
+  //missing data are not
+  server.FailNext(1, 404);
+  BOOST_CHECK_THROW(folder.UpdateData(EventTime(1465000000)), lariov::WebError);
+  BOOST_CHECK(!folder.IsStale());
+  BOOST_CHECK_EQUAL(server.NRequests(), 4);
+
+  //nor is a server failing for longer than the maximum stale age
+  folder.SetMaxStaleAge(1);
+  server.FailNext(1000);
+  BOOST_CHECK(!folder.UpdateData(EventTime(1465000001)));
+  BOOST_CHECK(folder.IsStale());
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  BOOST_CHECK_THROW(folder.UpdateData(EventTime(1465000002)), lariov::WebError);
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1450000000));
+  server.FailNext(0);
+}
+
+
+BOOST_AUTO_TEST_CASE(CompressedPayload) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  server.SetChannels(100000);
+
+  lariov::DBFolder plain("pedestals", server.URL());
+  BOOST_CHECK(plain.UpdateData(EventTime(1445000000)));
+  const size_t plain_bytes = server.BytesSent();
+
+  server.SetCompression(true);
+  lariov::DBFolder gzipped("pedestals_gz", server.URL());
+  BOOST_CHECK(gzipped.UpdateData(EventTime(1445000000)));
+  const size_t gzip_bytes = server.BytesSent() - plain_bytes;
+
+  BOOST_REQUIRE_EQUAL(gzipped.CachedData()->NRows(), 100000U);
+  for (lariov::DBChannelID_t ch : {0U, 4567U, 99999U}) {
+    double a = 0., b = 0.;
+    plain.GetNamedChannelData(ch, "mean", a);
+    gzipped.GetNamedChannelData(ch, "mean", b);
+    BOOST_CHECK_EQUAL(a, b);
+    BOOST_CHECK_CLOSE(b, 400. + ch + 144, 1e-6);
+  }
+  BOOST_CHECK(gzip_bytes*2 < plain_bytes);
+  BOOST_TEST_MESSAGE("100000-channel payload: " << plain_bytes << " bytes plain, " << gzip_bytes << " gzipped");
+}
+
+
+BOOST_AUTO_TEST_CASE(ParserTakesAnyChunks) {
+
+  const std::string body =
+    "1440000000.000000\r\n-\r\n"
+    "channel,mean,shape,comment\r\n"
+    "bigint,real,real[],text\r\n"
+    "7,401.5,[1,2,3],\"noisy, sometimes\"\r\n"
+    "3,400.25,[4],\"say \"\"hi\"\"\"\r\n"
+    "5,402,[],";  //no end of line after the last row
+
+  //all at once, then one byte at a time
+  for (size_t chunk : {body.size(), size_t(1)}) {
+    lariov::DBWebReader::Parser parser;
+    for (size_t pos = 0; pos < body.size(); pos += chunk) parser.Feed(body.data() + pos, std::min(chunk, body.size() - pos));
+    std::shared_ptr<lariov::DBDataset> data = parser.Finish();
+
+    BOOST_REQUIRE(data);
+    BOOST_CHECK(data->Begin() == lariov::IOVTimeStamp(1440000000));
+    BOOST_CHECK(data->End() == lariov::IOVTimeStamp::MaxTimeStamp());
+    BOOST_REQUIRE_EQUAL(data->NRows(), 3U);
+    BOOST_CHECK_EQUAL(data->Channels()[0], 3U);
+    BOOST_CHECK_EQUAL(data->DoubleValue(0, data->Column("mean")), 400.25);
+    BOOST_CHECK_EQUAL(data->StringValue(0, data->Column("comment")), "say \"hi\"");
+    BOOST_CHECK_EQUAL(data->StringValue(2, data->Column("comment")), "noisy, sometimes");
+    BOOST_CHECK_EQUAL(data->StringValue(2, data->Column("shape")), "[1,2,3]");
+    BOOST_CHECK_EQUAL(data->StringValue(1, data->Column("comment")), "");
+  }
+
+  lariov::DBWebReader::Parser empty;
+  const std::string header = "1440000000\n1450000000\nchannel,mean\nbigint,real\n";
+  empty.Feed(header.data(), header.size());
+  BOOST_CHECK(!empty.Finish());
+
+  //with a filter, no row of its channels is a valid answer
+  lariov::DBChannelFilter filter;
+  filter.AddRange(100, 200);
+  lariov::DBWebReader::Parser filtered(filter);
+  const std::string other_rows = header + "1,2\n3,4\n";
+  filtered.Feed(other_rows.data(), other_rows.size());
+  std::shared_ptr<lariov::DBDataset> none = filtered.Finish();
+  BOOST_REQUIRE(none);
+  BOOST_CHECK_EQUAL(none->NRows(), 0U);
+  BOOST_CHECK(none->End() == lariov::IOVTimeStamp(1450000000));
+
+  lariov::DBWebReader::Parser bad;
+  const std::string short_row = header + "1,2\n3\n";
+  BOOST_CHECK_THROW(bad.Feed(short_row.data(), short_row.size()), lariov::WebError);
+}
+
+
+BOOST_AUTO_TEST_CASE(ConnectionsAreReused) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  const int nrequests = 300;
+
+  //a time scan, one IOV per request
+  auto scan = [&server, nrequests]() {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < nrequests; ++i) {
+      std::shared_ptr<lariov::DBDataset> data;
+      std::string message;
+      const std::string url = server.URL() + "/data?f=pedestals&t=" + std::to_string(1440000000 + i*kIOVLength);
+      BOOST_REQUIRE_EQUAL(lariov::DBWebReader::Fetch(url, 5, data, message), 200);
+      BOOST_REQUIRE(data);
+    }
+    return nrequests/Seconds(std::chrono::steady_clock::now() - start);
+  };
+
+  double fresh_rate = 0.;
+  {
+    NoKeepAlive fresh;
+    fresh_rate = scan();
+  }
+  const int fresh_connections = server.NConnections();
+  const double pooled_rate = scan();
+  const int pooled_connections = server.NConnections() - fresh_connections;
+
+  BOOST_CHECK_EQUAL(fresh_connections, nrequests);
+  BOOST_CHECK_EQUAL(pooled_connections, 1);
+  BOOST_TEST_MESSAGE(nrequests << " requests: " << fresh_rate << "/s with a connection each, "
+                     << pooled_rate << "/s through the pool");
+}
+
+
+BOOST_AUTO_TEST_CASE(ConnectionsPerHostAreBounded) {
+
+  MockServer server(std::chrono::milliseconds(100));
+  MaxPerHost max(2);
+
+  std::vector<std::thread> threads;
+  std::vector<int> status(6, 0);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 6; ++i) {
+    threads.emplace_back([&server, &status, i]() {
+      std::shared_ptr<lariov::DBDataset> data;
+      std::string message;
+      const std::string url = server.URL() + "/data?f=pedestals&t=" + std::to_string(1440000000 + i*kIOVLength);
+      status[i] = lariov::DBWebReader::Fetch(url, 5, data, message);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  const double elapsed = Seconds(std::chrono::steady_clock::now() - start);
+
+  for (int s : status) BOOST_CHECK_EQUAL(s, 200);
+
+  BOOST_CHECK_EQUAL(server.NConnections(), 2);
+  BOOST_CHECK_EQUAL(server.NRequests(), 6);
+  BOOST_CHECK(elapsed > 0.29); //three rounds of two
+}
+
+
+BOOST_AUTO_TEST_CASE(WaitForConnectionIsBounded) {
+
+  MaxPerHost max(1);
+  const std::string url = "http://localhost:1/data";
+
+  lariov::DBConnectionPool::Connection busy = lariov::DBConnectionPool::Get(url, 1);
+  BOOST_REQUIRE(busy.Handle());
+
+  //the only handle is out: the wait gives up after the timeout, with no handle
+  auto start = std::chrono::steady_clock::now();
+  lariov::DBConnectionPool::Connection late = lariov::DBConnectionPool::Get(url, 1);
+  const double elapsed = Seconds(std::chrono::steady_clock::now() - start);
+  BOOST_CHECK(!late.Handle());
+  BOOST_CHECK(elapsed > 0.9);
+}
+
+
+BOOST_AUTO_TEST_CASE(WaitForConnectionCountsAgainstTimeout) {
+
+  MockServer server(std::chrono::milliseconds(1500));
+  MaxPerHost max(1);
+  const std::string url = server.URL() + "/data?f=pedestals&t=1445000000.000000";
+
+  //the only handle is busy for 1.5 s, and so would be the next request
+  std::thread first([&url]() {
+    std::shared_ptr<lariov::DBDataset> data;
+    std::string message;
+    lariov::DBWebReader::Fetch(url, 10, data, message);
+  });
+  server.WaitForRequests(1);
+
+  auto start = std::chrono::steady_clock::now();
+  std::shared_ptr<lariov::DBDataset> data;
+  std::string message;
+  const int status = lariov::DBWebReader::Fetch(url, 2, data, message);
+  const double elapsed = Seconds(std::chrono::steady_clock::now() - start);
+  first.join();
+
+  BOOST_CHECK_EQUAL(status, 0);
+  BOOST_CHECK(elapsed < 2.5);
+  BOOST_TEST_MESSAGE("Fetch with a 2 s timeout gave up after " << elapsed << " s: " << message);
+}
+
+
+BOOST_AUTO_TEST_CASE(ChannelSubset) {
+
+  MockServer server(std::chrono::milliseconds(0));
+  server.SetChannels(1000);
+
+  lariov::DBChannelFilter filter;
+  filter.AddRange(100, 199);
+  filter.AddChannel(7);
+  filter.AddRange(150, 250);
+  BOOST_CHECK_EQUAL(filter.ToString(), "7,100-250");
+  BOOST_CHECK(filter.Contains(7) && filter.Contains(250) && !filter.Contains(8) && !filter.Contains(251));
+
+  auto check = [&filter](lariov::DBFolder& folder) {
+    std::vector<lariov::DBChannelID_t> channels;
+    folder.GetChannelList(channels);
+    BOOST_CHECK_EQUAL(channels.size(), 152U);
+    for (lariov::DBChannelID_t ch : channels) BOOST_CHECK(filter.Contains(ch));
+    double mean = 0.;
+    folder.GetNamedChannelData(120, "mean", mean);
+    BOOST_CHECK_CLOSE(mean, 400. + 120 + 144, 1e-6);
+    BOOST_CHECK_THROW(folder.GetNamedChannelData(99, "mean", mean), lariov::WebError);
+  };
+
+  //the whole payload, for reference
+  lariov::DBFolder whole("pedestals", server.URL());
+  whole.UpdateData(EventTime(1445000000));
+  const size_t whole_bytes = server.BytesSent();
+
+  //a server ignoring the subset sends everything; the other rows are dropped while decoding
+  lariov::DBFolder decoded("pedestals", server.URL());
+  decoded.SetChannelFilter(filter, true);
+  decoded.UpdateData(EventTime(1445000000));
+  check(decoded);
+  BOOST_CHECK_EQUAL(server.BytesSent() - whole_bytes, whole_bytes);
+
+  //a server honouring it only sends the subset; the folder reading the same subset shares the payload
+  server.SetChannelQuery(true);
+  lariov::DBFolder queried("pedestals", server.URL());
+  lariov::DBFolder same("pedestals", server.URL());
+  queried.SetChannelFilter(filter, true);
+  same.SetChannelFilter(filter, true);
+  queried.UpdateData(EventTime(1455000000));
+  same.UpdateData(EventTime(1455000000));
+  BOOST_CHECK(queried.CachedData() == same.CachedData());
+  BOOST_CHECK_EQUAL(server.NRequests(), 3);
+  const size_t subset_bytes = server.BytesSent() - 2*whole_bytes;
+  BOOST_CHECK(subset_bytes < whole_bytes/4);
+  queried.UpdateData(EventTime(1445000000));
+  check(queried);
+
+  BOOST_TEST_MESSAGE("Payload of " << whole.CachedData()->NRows() << " channels: " << whole_bytes
+                     << " bytes, of the " << queried.CachedData()->NRows() << " channels of a subset: "
+                     << subset_bytes << " bytes");
+}
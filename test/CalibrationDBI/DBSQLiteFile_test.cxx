@@ -0,0 +1,252 @@
+/**
+ * @file   DBSQLiteFile_test.cxx
+ * @brief  Test of the SQLite file backend of DBFolder, also reading a subset of the channels
+ *
+ * Payloads written by DBSQLiteWriter should read back with the IOV bounds and
+ * the values they were written with, to the last bit of a double.
+ */
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( dbsqlitefile_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+#include "larevt/CalibrationDBI/Providers/DBFolder.h"
+#include "larevt/CalibrationDBI/Providers/DBSQLiteFile.h"
+#include "larevt/CalibrationDBI/Providers/DatabaseRetrievalAlg.h"
+
+// C/C++ standard library
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+  const std::string kFolder = "detpedestals";
+
+  lariov::DBDataset MakePedestals(const lariov::IOVTimeStamp& begin, const lariov::IOVTimeStamp& end, const char* mean) {
+    lariov::DBDataset data(begin, end,
+                           {"channel", "mean", "ok", "shape"},
+                           {"integer", "real", "boolean", "real[]"});
+    const char* row0[] = {"0", mean, "True", "[1,2,3]"};
+    const char* row1[] = {"1", mean, "False", "[4]"};
+    data.AddRow(row0);
+    data.AddRow(row1);
+    data.Finalize();
+    return data;
+  }
+
+} // local namespace
+
+
+BOOST_AUTO_TEST_CASE(WriteAndRead) {
+
+  const std::string file = "DBSQLiteFile_test.db";
+  std::remove(file.c_str());
+
+  {
+    lariov::DBSQLiteWriter writer(file, kFolder);
+    writer.Write(MakePedestals(1440000000, 1450000000, "400.5"));
+    writer.Write(MakePedestals(1450000000, 1460000000, "401.5"), "v1");
+    writer.Write(MakePedestals(1460000000, 1470000000, "402.5"));
+  }
+
+  lariov::DBFolder folder(kFolder, file, "", true);
+  BOOST_CHECK(folder.UsesSQLite());
+
+  BOOST_CHECK(folder.UpdateData(1445000000000000000ULL));
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1440000000));
+  BOOST_CHECK(folder.CachedEnd() == lariov::IOVTimeStamp(1450000000));
+
+  double mean = 0.;
+  folder.GetNamedChannelData(1, "mean", mean);
+  BOOST_CHECK_EQUAL(mean, 400.5);
+
+  bool ok = false;
+  folder.GetNamedChannelData(0, "ok", ok);
+  BOOST_CHECK(ok);
+
+  std::vector<double> shape;
+  folder.GetNamedChannelData(0, "shape", shape);
+  BOOST_CHECK_EQUAL(shape.size(), 3U);
+
+  BOOST_CHECK(!folder.UpdateData(1449999999000000000ULL));
+  BOOST_CHECK(folder.UpdateData(1465000000000000000ULL));
+  BOOST_CHECK(folder.CachedEnd() == lariov::IOVTimeStamp(1470000000));
+
+  // the last IOV ends where it was written to end
+  BOOST_CHECK_THROW(folder.UpdateData(1475000000000000000ULL), std::exception);
+
+  // only the second IOV belongs to tag v1
+  lariov::DBFolder tagged(kFolder, file, "v1", true);
+  BOOST_CHECK(tagged.UpdateData(1455000000000000000ULL));
+  tagged.GetNamedChannelData(0, "mean", mean);
+  BOOST_CHECK_EQUAL(mean, 401.5);
+  BOOST_CHECK(tagged.CachedEnd() == lariov::IOVTimeStamp(1460000000));
+  BOOST_CHECK_THROW(tagged.UpdateData(1445000000000000000ULL), std::exception);
+  BOOST_CHECK_THROW(tagged.UpdateData(1465000000000000000ULL), std::exception);
+
+  std::remove(file.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(BoundsAndPrecision) {
+
+  const std::string file = "DBSQLiteFile_test_bounds.db";
+  std::remove(file.c_str());
+
+  {
+    lariov::DBSQLiteWriter writer(file, kFolder);
+    writer.Write(MakePedestals(1440000000, 1450000000, "0.1"));
+    writer.Write(MakePedestals(1460000000, 1470000000, "0.3333333333333333"));
+    writer.Write(MakePedestals(1480000000, lariov::IOVTimeStamp::MaxTimeStamp(), "1e-300"));
+  }
+
+  lariov::DBFolder folder(kFolder, file, "", true);
+  BOOST_CHECK(folder.UpdateData(1445000000000000000ULL));
+  BOOST_CHECK(folder.CachedEnd() == lariov::IOVTimeStamp(1450000000));
+
+  // no IOV covers the gap
+  BOOST_CHECK_THROW(folder.UpdateData(1455000000000000000ULL), std::exception);
+
+  // reals are read back exactly, not through the 15 digits of their SQLite text
+  double mean = 0.;
+  BOOST_CHECK(folder.UpdateData(1465000000000000000ULL));
+  BOOST_CHECK(folder.CachedEnd() == lariov::IOVTimeStamp(1470000000));
+  folder.GetNamedChannelData(0, "mean", mean);
+  BOOST_CHECK_EQUAL(mean, 0.3333333333333333);
+
+  // an open-ended IOV stays open
+  BOOST_CHECK(folder.UpdateData(1485000000000000000ULL));
+  BOOST_CHECK(folder.CachedEnd() == lariov::IOVTimeStamp::MaxTimeStamp());
+  folder.GetNamedChannelData(0, "mean", mean);
+  BOOST_CHECK_EQUAL(mean, 1e-300);
+
+  // and so for preloaded IOVs
+  lariov::DBFolder preloaded(kFolder, file, "", true);
+  BOOST_CHECK_EQUAL(preloaded.Preload(lariov::IOVTimeStamp(1440000000), lariov::IOVTimeStamp(1490000000)), 3U);
+  BOOST_CHECK(preloaded.UpdateData(1465000000000000000ULL));
+  BOOST_CHECK(preloaded.CachedEnd() == lariov::IOVTimeStamp(1470000000));
+
+  std::remove(file.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(PreloadRange) {
+
+  const std::string file = "DBSQLiteFile_test_preload.db";
+  std::remove(file.c_str());
+
+  {
+    lariov::DBSQLiteWriter writer(file, kFolder);
+    writer.Write(MakePedestals(1440000000, 1450000000, "400.5"));
+    writer.Write(MakePedestals(1450000000, 1460000000, "401.5"));
+    writer.Write(MakePedestals(1460000000, 1470000000, "402.5"));
+  }
+
+  lariov::DBFolder folder(kFolder, file, "", true);
+
+  // the range touches the first two IOVs only
+  BOOST_CHECK_EQUAL(folder.Preload(lariov::IOVTimeStamp(1445000000), lariov::IOVTimeStamp(1450000000)), 2U);
+
+  double mean = 0.;
+  BOOST_CHECK(folder.UpdateData(1455000000000000000ULL));
+  BOOST_CHECK(folder.CachedStart() == lariov::IOVTimeStamp(1450000000));
+  BOOST_CHECK(folder.CachedEnd() == lariov::IOVTimeStamp(1460000000));
+  folder.GetNamedChannelData(1, "mean", mean);
+  BOOST_CHECK_EQUAL(mean, 401.5);
+
+  BOOST_CHECK(folder.UpdateData(1441000000000000000ULL));
+  folder.GetNamedChannelData(1, "mean", mean);
+  BOOST_CHECK_EQUAL(mean, 400.5);
+
+  // outside the range the file is read as before
+  BOOST_CHECK(folder.UpdateData(1465000000000000000ULL));
+  folder.GetNamedChannelData(1, "mean", mean);
+  BOOST_CHECK_EQUAL(mean, 402.5);
+
+  std::remove(file.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(PreloadRunOfUnknownEnd) {
+
+  const std::string file = "DBSQLiteFile_test_run.db";
+  std::remove(file.c_str());
+
+  {
+    lariov::DBSQLiteWriter writer(file, kFolder);
+    writer.Write(MakePedestals(1440000000, 1450000000, "400.5"));
+    writer.Write(MakePedestals(1450000000, 1460000000, "401.5"));
+    writer.Write(MakePedestals(1460000000, 1470000000, "402.5"));
+  }
+
+  // a run only has its end time once it is over: the horizon stands in for it
+  lariov::DatabaseRetrievalAlg alg(kFolder, file, "", true);
+  alg.SetPreloadRun(true, 10000000);
+  alg.PreloadForRun(1445000000000000000ULL, 0);
+  BOOST_CHECK_EQUAL(alg.NPreloaded(), 2U);
+
+  // a known end is used as is
+  alg.PreloadForRun(1445000000000000000ULL, 1465000000000000000ULL);
+  BOOST_CHECK_EQUAL(alg.NPreloaded(), 3U);
+
+  // without a horizon, nothing is fetched up front
+  lariov::DatabaseRetrievalAlg none(kFolder, file, "", true);
+  none.SetPreloadRun(true, 0);
+  none.PreloadForRun(1445000000000000000ULL, 0);
+  BOOST_CHECK_EQUAL(none.NPreloaded(), 0U);
+
+  std::remove(file.c_str());
+}
+
+
+BOOST_AUTO_TEST_CASE(ChannelSubset) {
+
+  const std::string file = "DBSQLiteFile_test_subset.db";
+  std::remove(file.c_str());
+
+  {
+    lariov::DBSQLiteWriter writer(file, kFolder);
+    writer.Write(MakePedestals(1440000000, 1450000000, "400.5"));
+    writer.Write(MakePedestals(1450000000, 1460000000, "401.5"));
+  }
+
+  lariov::DBChannelFilter filter;
+  filter.AddChannel(1);
+  lariov::DBFolder folder(kFolder, file, "", true);
+  folder.SetChannelFilter(filter);
+
+  // only the rows of the channel asked for are read
+  BOOST_CHECK(folder.UpdateData(1445000000000000000ULL));
+  std::vector<lariov::DBChannelID_t> channels;
+  folder.GetChannelList(channels);
+  BOOST_CHECK(channels == std::vector<lariov::DBChannelID_t>{1});
+  double mean = 0.;
+  folder.GetNamedChannelData(1, "mean", mean);
+  BOOST_CHECK_EQUAL(mean, 400.5);
+  BOOST_CHECK_THROW(folder.GetNamedChannelData(0, "mean", mean), std::exception);
+
+  // and so for preloaded IOVs
+  BOOST_CHECK_EQUAL(folder.Preload(lariov::IOVTimeStamp(1440000000), lariov::IOVTimeStamp(1460000000)), 2U);
+  BOOST_CHECK(folder.UpdateData(1455000000000000000ULL));
+  BOOST_CHECK_EQUAL(folder.CachedData()->NRows(), 1U);
+
+  // a subset without any channel in the file gets no row, for the whole IOV
+  lariov::DBChannelFilter none;
+  none.AddRange(100, 200);
+  lariov::DBFolder empty(kFolder, file, "", true);
+  empty.SetChannelFilter(none);
+  BOOST_CHECK(empty.UpdateData(1445000000000000000ULL));
+  BOOST_CHECK_EQUAL(empty.CachedData()->NRows(), 0U);
+  BOOST_CHECK(empty.CachedStart() == lariov::IOVTimeStamp(1440000000));
+  BOOST_CHECK(empty.CachedEnd() == lariov::IOVTimeStamp(1450000000));
+  BOOST_CHECK(!empty.UpdateData(1449000000000000000ULL));
+  BOOST_CHECK_EQUAL(empty.Preload(lariov::IOVTimeStamp(1440000000), lariov::IOVTimeStamp(1460000000)), 2U);
+
+  std::remove(file.c_str());
+}
@@ -0,0 +1,358 @@
+/**
+ * @file   ProviderAccess_test.cxx
+ * @brief  Test of the per-channel accessors of DetPedestalRetrievalAlg
+ *
+ * The provider is validated for the event time once, by Update(); the
+ * accessors then only look the channel up in the current snapshot.  The
+ * benchmark compares that with the former behaviour, where every accessor
+ * call checked the event time against the cached IOV first.  At an IOV
+ * switch where few channels change, only those are read again.  Columns
+ * are resolved once per payload into typed handles, checked against the
+ * column types.  The batch accessors of the provider interface fill the
+ * values of many channels in one call and must agree with the others.
+ * With lazy rows, only the rows of the channels used are decoded, and
+ * IOV switches do not compare the payloads.  A
+ * reconfigured provider reads its next IOV whole.
+ */
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( provideraccess_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// LArSoft libraries
+#include "fhiclcpp/ParameterSet.h"
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/Providers/DBDataset.h"
+#include "larevt/CalibrationDBI/Providers/DBSQLiteFile.h"
+#include "larevt/CalibrationDBI/Providers/DetPedestalRetrievalAlg.h"
+
+// C/C++ standard library
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+
+namespace {
+
+  const std::string kFile = "ProviderAccess_test.db";
+  const std::string kFolder = "detpedestals";
+  const unsigned int kNChannels = 8256;
+
+  const lariov::DBTimeStamp_t kFirstIOV  = 1445000000000000000ULL;
+  const lariov::DBTimeStamp_t kSecondIOV = 1455000000000000000ULL;
+  const lariov::DBTimeStamp_t kThirdIOV  = 1465000000000000000ULL;
+
+  /// Pedestals of all channels but the last nmissing; channels 5 and 70 are shifted by bump
+  lariov::DBDataset MakePedestals(unsigned long begin, unsigned long end, double offset,
+                                  double bump = 0., unsigned int nmissing = 0) {
+    lariov::DBDataset data(lariov::IOVTimeStamp(begin), lariov::IOVTimeStamp(end),
+                           {"channel", "mean", "mean_err", "rms", "rms_err"},
+                           {"bigint", "real", "real", "real", "real"});
+    for (unsigned int ch=0; ch < kNChannels - nmissing; ++ch) {
+      const std::string channel = std::to_string(ch);
+      const std::string mean = std::to_string(offset + ch%64 + ((ch == 5 || ch == 70) ? bump : 0.));
+      const char* row[] = {channel.c_str(), mean.c_str(), "0.1", "2.5", "0.01"};
+      data.AddRow(row);
+    }
+    data.Finalize();
+    return data;
+  }
+
+  /// Write two IOVs of pedestals once for all the test cases
+  struct PedestalFile {
+    PedestalFile() {
+      std::remove(kFile.c_str());
+      lariov::DBSQLiteWriter writer(kFile, kFolder);
+      writer.Write(MakePedestals(1440000000, 1450000000, 400.));
+      writer.Write(MakePedestals(1450000000, 1460000000, 2048.));
+      writer.Write(MakePedestals(1460000000, 1470000000, 2048., 3., 1));
+    }
+    ~PedestalFile() { std::remove(kFile.c_str()); }
+  };
+
+  double Seconds(std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+  }
+
+} // local namespace
+
+BOOST_GLOBAL_FIXTURE(PedestalFile);
+
+
+BOOST_AUTO_TEST_CASE(AccessorsFollowUpdate) {
+
+  lariov::DetPedestalRetrievalAlg alg(kFolder, kFile, "", true);
+
+  BOOST_CHECK(alg.Update(kFirstIOV));
+  BOOST_CHECK(!alg.Update(kFirstIOV + 1000));
+  BOOST_CHECK_CLOSE(alg.PedMean(65), 401., 1e-4);
+  BOOST_CHECK_CLOSE(alg.PedRms(65), 2.5, 1e-4);
+
+  BOOST_CHECK(alg.Update(kSecondIOV));
+  BOOST_CHECK_CLOSE(alg.PedMean(65), 2049., 1e-4);
+  BOOST_CHECK_CLOSE(alg.Pedestal(kNChannels-1).PedMeanErr(), 0.1, 1e-4);
+}
+
+
+BOOST_AUTO_TEST_CASE(OnlyChangedChannelsAreRead) {
+
+  lariov::DetPedestalRetrievalAlg alg(kFolder, kFile, "", true);
+
+  alg.Update(kFirstIOV);
+  BOOST_CHECK(alg.AllChannelsChanged());
+
+  //every mean moves
+  alg.Update(kSecondIOV);
+  BOOST_CHECK(!alg.AllChannelsChanged());
+  BOOST_CHECK_EQUAL(alg.ChangedChannels().size(), kNChannels);
+
+  //two channels move and the last one goes away
+  alg.Update(kThirdIOV);
+  const std::vector<unsigned int> expected = {5, 70, kNChannels-1};
+  BOOST_CHECK(!alg.AllChannelsChanged());
+  BOOST_CHECK(alg.ChangedChannels() == expected);
+  BOOST_CHECK_CLOSE(alg.PedMean(5), 2056., 1e-4);
+  BOOST_CHECK_CLOSE(alg.PedMean(6), 2054., 1e-4);
+  BOOST_CHECK_CLOSE(alg.PedMean(70), 2057., 1e-4);
+  BOOST_CHECK_THROW(alg.PedMean(kNChannels-1), std::exception);
+  BOOST_CHECK(alg.Begin() == lariov::IOVTimeStamp(1460000000));
+
+  //and back: the channel returns
+  alg.Update(kSecondIOV);
+  BOOST_CHECK(alg.ChangedChannels() == expected);
+  BOOST_CHECK_CLOSE(alg.PedMean(kNChannels-1), 2048. + (kNChannels-1)%64, 1e-4);
+  BOOST_CHECK_CLOSE(alg.PedMean(5), 2053., 1e-4);
+}
+
+
+BOOST_AUTO_TEST_CASE(ReconfigureBetweenIOVs) {
+
+  lariov::DetPedestalRetrievalAlg alg(kFolder, kFile, "", true);
+  alg.Update(kSecondIOV);
+
+  fhicl::ParameterSet db;
+  db.put("DBFolderName", kFolder);
+  db.put("DBUrl", kFile);
+  db.put("UseSQLite", true);
+  fhicl::ParameterSet config;
+  config.put("DatabaseRetrievalAlg", db);
+  config.put("UseDB", true);
+  alg.Reconfigure(config);
+
+  //the payloads differ in three channels, but there is no snapshot of the previous one to patch
+  BOOST_CHECK(alg.Update(kThirdIOV));
+  BOOST_CHECK(alg.AllChannelsChanged());
+  BOOST_CHECK_EQUAL(alg.CurrentSnapshot().NChannels(), kNChannels-1);
+  BOOST_CHECK_CLOSE(alg.PedMean(6), 2054., 1e-4);
+  BOOST_CHECK_CLOSE(alg.PedMean(70), 2057., 1e-4);
+}
+
+
+BOOST_AUTO_TEST_CASE(PerCallCost) {
+
+  lariov::DetPedestalRetrievalAlg alg(kFolder, kFile, "", true);
+  alg.Update(kFirstIOV);
+
+  const unsigned int nEvents = 200;
+  using clock = std::chrono::steady_clock;
+
+  //former accessors: every call validated the event time first
+  double checked_sum = 0.;
+  auto start = clock::now();
+  for (unsigned int evt=0; evt < nEvents; ++evt) {
+    for (unsigned int ch=0; ch < kNChannels; ++ch) {
+      alg.Update(kFirstIOV + evt);
+      checked_sum += alg.PedMean(ch);
+    }
+  }
+  const double checked = Seconds(clock::now() - start);
+
+  //current accessors: one validation per event
+  double plain_sum = 0.;
+  start = clock::now();
+  for (unsigned int evt=0; evt < nEvents; ++evt) {
+    alg.Update(kFirstIOV + evt);
+    for (unsigned int ch=0; ch < kNChannels; ++ch) {
+      plain_sum += alg.PedMean(ch);
+    }
+  }
+  const double plain = Seconds(clock::now() - start);
+
+  BOOST_CHECK_EQUAL(checked_sum, plain_sum);
+
+  const double ncalls = double(nEvents)*kNChannels;
+  BOOST_TEST_MESSAGE("PedMean() with a per-call IOV check: " << 1e9*checked/ncalls << " ns/call");
+  BOOST_TEST_MESSAGE("PedMean() after a per-event IOV check: " << 1e9*plain/ncalls << " ns/call");
+}
+
+
+BOOST_AUTO_TEST_CASE(ColumnHandles) {
+
+  lariov::DBDataset data = MakePedestals(1440000000, 1450000000, 400.);
+  auto mean = data.GetColumn<double>("mean");
+  auto rms = data.GetColumn<double>("rms");
+  const size_t mean_col = data.CheckedColumn("mean");
+  const size_t rms_col = data.CheckedColumn("rms");
+  for (size_t row=0; row < data.NRows(); row += 97) {
+    BOOST_CHECK_EQUAL(mean[row], data.DoubleValue(row, mean_col));
+    BOOST_CHECK_EQUAL(rms[row], data.DoubleValue(row, rms_col));
+  }
+
+  //the channel is not a column: it is read through Channels()
+  BOOST_CHECK_THROW(data.GetColumn<long>("channel"), std::exception);
+
+  //a wrong type or name is caught when the columns are resolved, not on the first access
+  BOOST_CHECK_THROW(data.GetColumn<long>("mean"), std::exception);
+  BOOST_CHECK_THROW(data.GetColumn<std::string>("rms"), std::exception);
+  BOOST_CHECK_THROW(data.GetColumn<double>("gain"), std::exception);
+
+  lariov::DBDataset text(lariov::IOVTimeStamp(1440000000), lariov::IOVTimeStamp(1450000000),
+                         {"channel", "mean", "mean_err", "rms", "rms_err"},
+                         {"bigint", "text", "real", "real", "real"});
+  const char* row[] = {"0", "400", "0.1", "2.5", "0.01"};
+  text.AddRow(row);
+  text.Finalize();
+  BOOST_CHECK_THROW(text.GetColumn<double>("mean"), std::exception);
+  BOOST_CHECK_EQUAL(text.GetColumn<std::string>("mean")[0], "400");
+
+  //integer columns are read as doubles, e.g. a gain stored as a whole number
+  lariov::DBDataset integers(lariov::IOVTimeStamp(1440000000), lariov::IOVTimeStamp(1450000000),
+                             {"channel", "mean", "mean_err", "rms", "rms_err"},
+                             {"bigint", "integer", "real", "real", "real"});
+  integers.AddRow(row);
+  integers.Finalize();
+  BOOST_CHECK_EQUAL(integers.GetColumn<double>("mean")[0], 400.);
+  BOOST_CHECK_EQUAL(integers.GetColumn<double>("rms")[0], 2.5);
+}
+
+
+BOOST_AUTO_TEST_CASE(SchemaDecoding) {
+
+  const lariov::DBDataset data = MakePedestals(1440000000, 1450000000, 400.);
+  lariov::Snapshot<lariov::DetPedestal> snapshot;
+  lariov::ReadRows(data, snapshot);
+  BOOST_CHECK_EQUAL(snapshot.NChannels(), kNChannels);
+  BOOST_CHECK_CLOSE(snapshot.GetRow(65).PedMean(), 401., 1e-4);
+  BOOST_CHECK_CLOSE(snapshot.GetRow(65).PedRmsErr(), 0.01, 1e-4);
+
+  //patching only given rows keeps the others
+  const lariov::DBDataset bumped = MakePedestals(1450000000, 1460000000, 400., 3.);
+  const std::vector<size_t> rows = {5};
+  lariov::ReadRows(bumped, snapshot, &rows);
+  BOOST_CHECK_EQUAL(snapshot.NChannels(), kNChannels);
+  BOOST_CHECK_CLOSE(snapshot.GetRow(5).PedMean(), 408., 1e-4);
+  BOOST_CHECK_CLOSE(snapshot.GetRow(70).PedMean(), 406., 1e-4);
+}
+
+
+BOOST_AUTO_TEST_CASE(BatchAccessors) {
+
+  lariov::DetPedestalRetrievalAlg alg(kFolder, kFile, "", true);
+  alg.Update(kThirdIOV);
+  const lariov::DetPedestalProvider& provider = alg;
+
+  //the channels of one readout board, in order, and a few out of order
+  std::vector<raw::ChannelID_t> channels;
+  for (unsigned int ch=64; ch < 128; ++ch) channels.push_back(ch);
+  channels.push_back(5);
+  channels.push_back(70);
+
+  std::vector<float> means(channels.size()), rms(channels.size());
+  provider.FillPedMean(channels.data(), channels.size(), means.data());
+  provider.FillPedRms(channels.data(), channels.size(), rms.data());
+  for (size_t i=0; i < channels.size(); ++i) {
+    BOOST_CHECK_EQUAL(means[i], provider.PedMean(channels[i]));
+    BOOST_CHECK_EQUAL(rms[i], provider.PedRms(channels[i]));
+  }
+
+  //a channel without pedestal throws as the single-channel accessor does
+  channels.push_back(kNChannels-1);
+  means.resize(channels.size());
+  BOOST_CHECK_THROW(provider.FillPedMean(channels.data(), channels.size(), means.data()), std::exception);
+
+  //all the channels, once per event
+  const unsigned int nEvents = 200;
+  using clock = std::chrono::steady_clock;
+  std::vector<raw::ChannelID_t> all;
+  for (unsigned int ch=0; ch < kNChannels-1; ++ch) all.push_back(ch);
+  std::vector<float> values(all.size());
+
+  double single_sum = 0.;
+  auto start = clock::now();
+  for (unsigned int evt=0; evt < nEvents; ++evt) {
+    for (raw::ChannelID_t ch : all) single_sum += provider.PedMean(ch);
+  }
+  const double single = Seconds(clock::now() - start);
+
+  double batch_sum = 0.;
+  start = clock::now();
+  for (unsigned int evt=0; evt < nEvents; ++evt) {
+    provider.FillPedMean(all.data(), all.size(), values.data());
+    for (float v : values) batch_sum += v;
+  }
+  const double batch = Seconds(clock::now() - start);
+
+  BOOST_CHECK_EQUAL(single_sum, batch_sum);
+
+  const double nvalues = double(nEvents)*all.size();
+  BOOST_TEST_MESSAGE("PedMean() per channel: " << 1e9*single/nvalues << " ns/channel");
+  BOOST_TEST_MESSAGE("FillPedMean() for all channels: " << 1e9*batch/nvalues << " ns/channel");
+}
+
+
+BOOST_AUTO_TEST_CASE(LazyRows) {
+
+  lariov::DetPedestalRetrievalAlg eager(kFolder, kFile, "", true);
+  lariov::DetPedestalRetrievalAlg lazy(kFolder, kFile, "", true);
+  lazy.SetLazyRows(true);
+
+  eager.Update(kSecondIOV);
+  lazy.Update(kSecondIOV);
+  BOOST_CHECK(lazy.CurrentSnapshot().IsLazy());
+  BOOST_CHECK_EQUAL(lazy.CurrentSnapshot().NChannels(), kNChannels);
+  BOOST_CHECK_EQUAL(lazy.CurrentSnapshot().NRowsMade(), 0U);
+
+  //only the channels used are decoded
+  for (unsigned int ch=64; ch < 128; ++ch) {
+    BOOST_CHECK_EQUAL(lazy.PedMean(ch), eager.PedMean(ch));
+    BOOST_CHECK_EQUAL(lazy.PedRmsErr(ch), eager.PedRmsErr(ch));
+  }
+  BOOST_CHECK_EQUAL(lazy.CurrentSnapshot().NRowsMade(), 64U);
+
+  //the switch does not compare the payloads: every channel counts as changed
+  eager.Update(kThirdIOV);
+  lazy.Update(kThirdIOV);
+  BOOST_CHECK(!eager.AllChannelsChanged());
+  BOOST_CHECK(lazy.AllChannelsChanged());
+  BOOST_CHECK(lazy.ChangedChannels().empty());
+  BOOST_CHECK_EQUAL(lazy.CurrentSnapshot().NChannels(), kNChannels-1);
+  BOOST_CHECK_EQUAL(lazy.CurrentSnapshot().NRowsMade(), 0U);
+  BOOST_CHECK_CLOSE(lazy.PedMean(70), 2057., 1e-4);
+  BOOST_CHECK(!lazy.CurrentSnapshot().HasChannel(kNChannels-1));
+  BOOST_CHECK_THROW(lazy.PedMean(kNChannels-1), std::exception);
+
+  std::vector<raw::ChannelID_t> channels = {5, 6, 70};
+  std::vector<float> means(channels.size());
+  lazy.FillPedMean(channels.data(), channels.size(), means.data());
+  for (size_t i=0; i < channels.size(); ++i) BOOST_CHECK_EQUAL(means[i], eager.PedMean(channels[i]));
+
+  //IOV switches of a job reading one board of channels
+  const unsigned int nSwitches = 50;
+  using clock = std::chrono::steady_clock;
+  double sums[2] = {0., 0.};
+  double times[2];
+  lariov::DetPedestalRetrievalAlg* algs[2] = {&eager, &lazy};
+  for (int a=0; a < 2; ++a) {
+    auto start = clock::now();
+    for (unsigned int s=0; s < nSwitches; ++s) {
+      algs[a]->Update(s%2 ? kSecondIOV : kFirstIOV);
+      for (unsigned int ch=64; ch < 128; ++ch) sums[a] += algs[a]->PedMean(ch);
+    }
+    times[a] = Seconds(clock::now() - start);
+  }
+  BOOST_CHECK_EQUAL(sums[0], sums[1]);
+  BOOST_TEST_MESSAGE("IOV switch using 64 of " << kNChannels << " channels: " << 1e3*times[0]/nSwitches
+                     << " ms decoding all rows, " << 1e3*times[1]/nSwitches << " ms with lazy rows");
+}
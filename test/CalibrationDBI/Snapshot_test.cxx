@@ -0,0 +1,128 @@
+/**
+ * @file   Snapshot_test.cxx
+ * @brief  Test of the rows and field columns of a conditions snapshot
+ *
+ * Snapshots keep their rows in channel order and hold their fields as
+ * contiguous columns, made on first use and shared by the threads reading
+ * them.
+ */
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( snapshot_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/IOVData/DetPedestal.h"
+#include "larevt/CalibrationDBI/IOVData/Snapshot.h"
+
+// C/C++ standard library
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+
+namespace {
+
+  const unsigned int kNChannels = 1000;
+
+  /// A snapshot in which every channel has the pedestal value gen
+  std::unique_ptr<lariov::Snapshot<lariov::DetPedestal>> MakeSnapshot(unsigned int gen) {
+    auto data = std::make_unique<lariov::Snapshot<lariov::DetPedestal>>();
+    data->SetIoV(lariov::IOVTimeStamp(gen), lariov::IOVTimeStamp(gen+1));
+    for (unsigned int ch=0; ch < kNChannels; ++ch) {
+      lariov::DetPedestal pd(ch);
+      pd.SetPedMean(gen);
+      pd.SetPedRms(1.f);
+      pd.SetPedMeanErr(0.f);
+      pd.SetPedRmsErr(0.f);
+      data->AddOrReplaceRow(pd);
+    }
+    return data;
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(ColumnsMatchRows) {
+
+  const auto snapshot = MakeSnapshot(3);
+  const lariov::Snapshot<lariov::DetPedestal>& data = *snapshot;
+  using Fields = lariov::SnapshotFields<lariov::DetPedestal>;
+
+  //filling the rows does not make the columns, their first use does
+  BOOST_CHECK(!data.HasColumns());
+  const lariov::FieldView means = data.Field(Fields::kPedMean);
+  const lariov::FieldView rms = data.Field(Fields::kPedRms);
+  BOOST_REQUIRE_EQUAL(data.Channels().size(), kNChannels);
+  BOOST_REQUIRE_EQUAL(means.size(), kNChannels);
+  for (size_t i=0; i < kNChannels; ++i) {
+    BOOST_CHECK_EQUAL(data.Channels()[i], data.Data()[i].Channel());
+    BOOST_CHECK_EQUAL(means[i], data.Data()[i].PedMean());
+    BOOST_CHECK_EQUAL(rms[i], data.Data()[i].PedRms());
+  }
+
+  BOOST_CHECK(data.HasColumns());
+
+  //a copy shares the columns until its rows change
+  lariov::Snapshot<lariov::DetPedestal> copy(data);
+  BOOST_CHECK(copy.HasColumns());
+  copy.RemoveRow(0);
+  BOOST_CHECK(!copy.HasColumns());
+  BOOST_CHECK_EQUAL(copy.Field(Fields::kPedMean).size(), kNChannels-1);
+  BOOST_CHECK_EQUAL(copy.Channels().front(), 1U);
+  BOOST_CHECK_EQUAL(data.Field(Fields::kPedMean).size(), kNChannels);
+
+  //pedestal subtraction over all channels, through the rows and through the column
+  const int nloops = 10000;
+  using clock = std::chrono::steady_clock;
+  float row_sum = 0.f, column_sum = 0.f;
+  auto start = clock::now();
+  for (int l=0; l < nloops; ++l) for (const auto& row : data.Data()) row_sum += 2048.f - row.PedMean();
+  const double by_row = std::chrono::duration<double>(clock::now() - start).count();
+  start = clock::now();
+  for (int l=0; l < nloops; ++l) for (float mean : means) column_sum += 2048.f - mean;
+  const double by_column = std::chrono::duration<double>(clock::now() - start).count();
+
+  BOOST_CHECK_EQUAL(row_sum, column_sum);
+  BOOST_TEST_MESSAGE("Pedestal subtraction over " << kNChannels << " channels: " << 1e6*by_row/nloops
+                     << " us through rows, " << 1e6*by_column/nloops << " us through the column");
+}
+
+
+BOOST_AUTO_TEST_CASE(ColumnsAreMadeOnce) {
+
+  const auto data = MakeSnapshot(2);
+  using Fields = lariov::SnapshotFields<lariov::DetPedestal>;
+
+  //readers asking for the columns together all get the same ones
+  std::vector<const float*> seen(8, nullptr);
+  std::vector<std::thread> readers;
+  for (size_t i=0; i < seen.size(); ++i) {
+    readers.emplace_back([&data, &seen, i]() { seen[i] = data->Field(Fields::kPedMean).begin(); });
+  }
+  for (auto& t : readers) t.join();
+
+  for (const float* values : seen) BOOST_CHECK_EQUAL(values, seen.front());
+  BOOST_CHECK_EQUAL(seen.front()[kNChannels-1], 2.f);
+}
+
+
+BOOST_AUTO_TEST_CASE(RowsStayInChannelOrder) {
+
+  //rows added out of order, some of them twice
+  lariov::Snapshot<lariov::DetPedestal> data;
+  const unsigned int channels[] = {7, 3, 9, 0, 3, 5, 9};
+  for (unsigned int i=0; i < sizeof(channels)/sizeof(channels[0]); ++i) {
+    lariov::DetPedestal pd(channels[i]);
+    pd.SetPedMean(i);
+    data.AddOrReplaceRow(pd);
+  }
+
+  BOOST_REQUIRE_EQUAL(data.NChannels(), 5U);
+  const unsigned int sorted[] = {0, 3, 5, 7, 9};
+  for (unsigned int i=0; i < 5; ++i) BOOST_CHECK_EQUAL(data.Data()[i].Channel(), sorted[i]);
+  BOOST_CHECK_EQUAL(data.GetRow(3).PedMean(), 4.f);
+  BOOST_CHECK_EQUAL(data.GetRow(9).PedMean(), 6.f);
+  BOOST_CHECK_EQUAL(data.GetRow(7).PedMean(), 0.f);
+}
@@ -0,0 +1,119 @@
+/**
+ * @file   TimeStampDecoder_test.cxx
+ * @brief  Test of IOVTimeStamp and TimeStampDecoder
+ *
+ * The decoder works on integers only; it is checked here against known
+ * values and against cutting the printed time into its digits, without
+ * going through IOVTimeStamp::GetFromString.
+ */
+
+// Boost libraries
+#define BOOST_TEST_MODULE ( timestampdecoder_test )
+#include <cetlib/quiet_unit_test.hpp> // BOOST_AUTO_TEST_CASE()
+#include <boost/test/test_tools.hpp> // BOOST_CHECK(), BOOST_CHECK_EQUAL()
+
+// LArSoft libraries
+#include "larevt/CalibrationDBI/IOVData/IOVDataError.h"
+#include "larevt/CalibrationDBI/IOVData/IOVTimeStamp.h"
+#include "larevt/CalibrationDBI/IOVData/TimeStampDecoder.h"
+
+// C/C++ standard library
+#include <chrono>
+#include <random>
+#include <string>
+#include <utility>
+
+
+namespace {
+
+  /// Reference decoding: print, then take the first ten digits as seconds and the next six as microseconds
+  lariov::IOVTimeStamp StringDecode(lariov::DBTimeStamp_t ts) {
+    const std::string time = std::to_string(ts);
+    if (time.length() == 19) {
+      return lariov::IOVTimeStamp(std::stoul(time.substr(0, 10)), std::stoul(time.substr(10, 6)));
+    }
+    else if (time.length() >= 6 || ts == 0) {
+      throw lariov::IOVDataError("cannot decode " + time);
+    }
+    return lariov::IOVTimeStamp(std::stoul(time));
+  }
+
+} // local namespace
+
+
+BOOST_AUTO_TEST_CASE(DBStampFormat) {
+
+  BOOST_CHECK_EQUAL(lariov::IOVTimeStamp(1445000000, 42).DBStamp(), "1445000000.000042");
+  BOOST_CHECK_EQUAL(lariov::IOVTimeStamp(0).DBStamp(), "0.000000");
+  BOOST_CHECK_EQUAL(lariov::IOVTimeStamp::MaxTimeStamp().DBStamp(), "18446744073709551615.999999");
+
+  BOOST_CHECK(lariov::IOVTimeStamp::GetFromString("12.5") == lariov::IOVTimeStamp(12, 500000));
+  BOOST_CHECK(lariov::IOVTimeStamp::GetFromString("12") == lariov::IOVTimeStamp(12));
+  BOOST_CHECK(lariov::IOVTimeStamp::GetFromString("1445000000.000042")
+              == lariov::IOVTimeStamp(1445000000, 42));
+
+  BOOST_CHECK_THROW(lariov::IOVTimeStamp::GetFromString("12.1234567"), lariov::IOVDataError);
+  BOOST_CHECK_THROW(lariov::IOVTimeStamp::GetFromString("12.x"), lariov::IOVDataError);
+  BOOST_CHECK_THROW(lariov::IOVTimeStamp::GetFromString(""), lariov::IOVDataError);
+  BOOST_CHECK_THROW(lariov::IOVTimeStamp(1, 1000000), lariov::IOVDataError);
+}
+
+
+BOOST_AUTO_TEST_CASE(MatchesStringDecoding) {
+
+  const std::pair<lariov::DBTimeStamp_t, lariov::IOVTimeStamp> samples[] = {
+    {1, lariov::IOVTimeStamp(1)},
+    {99999, lariov::IOVTimeStamp(99999)},
+    {1000000000000000000ULL, lariov::IOVTimeStamp(1000000000)},
+    {1445000000123456789ULL, lariov::IOVTimeStamp(1445000000, 123456)},
+    {1445000000000042999ULL, lariov::IOVTimeStamp(1445000000, 42)},
+    {9999999999999999999ULL, lariov::IOVTimeStamp(9999999999, 999999)}
+  };
+  for (const auto& sample : samples) {
+    BOOST_CHECK(lariov::TimeStampDecoder::DecodeTimeStamp(sample.first) == sample.second);
+    BOOST_CHECK(StringDecode(sample.first) == sample.second);
+  }
+
+  std::mt19937_64 gen(20161016);
+  std::uniform_int_distribution<lariov::DBTimeStamp_t> ns(1000000000000000000ULL, 9999999999999999999ULL);
+  for (int i=0; i < 100000; ++i) {
+    const lariov::DBTimeStamp_t ts = ns(gen);
+    const lariov::IOVTimeStamp decoded = lariov::TimeStampDecoder::DecodeTimeStamp(ts);
+    BOOST_CHECK(decoded == StringDecode(ts));
+    BOOST_CHECK(lariov::IOVTimeStamp::GetFromString(decoded.DBStamp()) == decoded);
+  }
+
+  const lariov::DBTimeStamp_t bad[] = { 0, 100000, 999999999999999999ULL, 10000000000000000000ULL };
+  for (lariov::DBTimeStamp_t ts : bad) {
+    BOOST_CHECK_THROW(lariov::TimeStampDecoder::DecodeTimeStamp(ts), lariov::IOVDataError);
+  }
+}
+
+
+BOOST_AUTO_TEST_CASE(DecodeCost) {
+
+  using clock = std::chrono::steady_clock;
+  const int n = 1000000;
+  const lariov::DBTimeStamp_t first = 1445000000000000000ULL;
+  const lariov::IOVTimeStamp begin(1440000000), end(1450000000);
+
+  //what DBFolder::UpdateData does for an event inside the cached IOV
+  int valid = 0;
+  auto start = clock::now();
+  for (int i=0; i < n; ++i) {
+    const lariov::IOVTimeStamp ts = StringDecode(first + 1000*(lariov::DBTimeStamp_t)i);
+    valid += (ts >= begin && ts < end);
+  }
+  const double strings = std::chrono::duration<double>(clock::now() - start).count();
+
+  start = clock::now();
+  for (int i=0; i < n; ++i) {
+    const lariov::IOVTimeStamp ts = lariov::TimeStampDecoder::DecodeTimeStamp(first + 1000*(lariov::DBTimeStamp_t)i);
+    valid += (ts >= begin && ts < end);
+  }
+  const double integers = std::chrono::duration<double>(clock::now() - start).count();
+
+  BOOST_CHECK_EQUAL(valid, 2*n);
+  BOOST_TEST_MESSAGE("Decode and validate through strings: " << 1e9*strings/n << " ns");
+  BOOST_TEST_MESSAGE("Decode and validate with integers: " << 1e9*integers/n << " ns");
+}